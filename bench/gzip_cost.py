@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+"""Bytes on the wire and worker CPU ticks for repeated GETs of one path.
+
+usage: gzip_cost.py PORT WORKER_PID PATH COUNT identity|gzip
+
+Each request uses its own connection and reads the response to EOF, so the
+byte count is the whole response (head included). CPU is utime + stime of
+the worker from /proc, in clock ticks.
+"""
+import socket
+import sys
+
+
+def cpu_ticks(pid):
+    fields = open("/proc/%d/stat" % pid).read().rsplit(")", 1)[1].split()
+    return int(fields[11]) + int(fields[12])
+
+
+def fetch(port, path, gzip):
+    sock = socket.create_connection(("127.0.0.1", port))
+    head = "GET %s HTTP/1.1\r\nHost: bench\r\nConnection: close\r\n" % path
+    if gzip:
+        head += "Accept-Encoding: gzip\r\n"
+    sock.sendall((head + "\r\n").encode())
+    data = bytearray()
+    while True:
+        chunk = sock.recv(1 << 20)
+        if not chunk:
+            break
+        data += chunk
+    sock.close()
+    header = bytes(data.split(b"\r\n\r\n", 1)[0]).lower()
+    return len(data), b"content-encoding: gzip" in header
+
+
+def main():
+    port, pid, path, count = int(sys.argv[1]), int(sys.argv[2]), sys.argv[3], int(sys.argv[4])
+    gzip = sys.argv[5] == "gzip"
+    before = cpu_ticks(pid)
+    total = 0
+    compressed = 0
+    for _ in range(count):
+        size, encoded = fetch(port, path, gzip)
+        total += size
+        compressed += encoded
+    print("%-10s %s x%d: %d B/request, %d compressed, %d ticks"
+          % (sys.argv[5], path, count, total // count, compressed, cpu_ticks(pid) - before))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,58 @@
+#!/bin/sh
+# Bytes on the wire against worker CPU for on-the-fly gzip: a 20k-entry
+# directory listing and a 4.8 MB CGI stream, uncompressed and at
+# gzip_comp_level 1, 6 and 9; then how many of 30 CGI responses are still
+# compressed at level 6 as gzip_cpu_budget shrinks.
+#
+# Run from the repository root after `make`:  sh bench/gzip_cost.sh
+# WEBSERV and PORT override the binary and the port (default 8090).
+set -e
+
+WEBSERV=${WEBSERV:-./webserv}
+PORT=${PORT:-8090}
+WORK=$(mktemp -d)
+PID=
+
+stop() {
+    if [ -n "$PID" ]; then
+        kill "$PID" 2>/dev/null || true
+        wait "$PID" 2>/dev/null || true
+        PID=
+    fi
+}
+trap 'stop; rm -rf "$WORK"' EXIT
+
+start() {
+    sed -e "s|@ROOT@|$WORK/www|g" -e "s|@PORT@|$PORT|" \
+        -e "s|@LEVEL@|$1|g" -e "s|@BUDGET@|$2|" bench/gzip.conf > "$WORK/gzip.conf"
+    "$WEBSERV" "$WORK/gzip.conf" > /dev/null 2>&1 &
+    PID=$!
+    sleep 1
+}
+
+measure() {
+    python3 bench/gzip_cost.py "$PORT" "$PID" "$@"
+}
+
+mkdir -p "$WORK/www/listing" "$WORK/www/cgi"
+(cd "$WORK/www/listing" && seq 1 20000 | sed 's/.*/file_with_a_longish_name_&.txt/' | xargs touch)
+cp bench/stream.py "$WORK/www/cgi/stream.py"
+
+start 1 100
+measure /listing/ 20 identity
+measure /cgi/stream.py 20 identity
+stop
+for level in 1 6 9; do
+    echo "gzip_comp_level $level"
+    start "$level" 100
+    measure /listing/ 20 gzip
+    measure /cgi/stream.py 20 gzip
+    stop
+done
+
+for budget in 100 20 5 0; do
+    echo "gzip_cpu_budget $budget"
+    start 6 "$budget"
+    measure /cgi/stream.py 30 gzip
+    stop
+done
@@ -0,0 +1,114 @@
+// Keep-alive load generator. Opens IDLE connections, sends one GET on each
+// and leaves them open, then issues sequential GETs on one more connection
+// for SECONDS and prints the request rate. With O(1) event dispatch the
+// rate should not depend on IDLE.
+//
+//   c++ -O2 -o keepalive_load bench/keepalive_load.cpp
+//   ./keepalive_load IDLE [PORT] [SECONDS] [PATH]
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static int connectTo(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd == -1 || connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+        std::fprintf(stderr, "connect: %s\n", std::strerror(errno));
+        std::exit(1);
+    }
+    return fd;
+}
+
+static double now() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = send(fd, data.data() + sent, data.size() - sent, 0);
+        if (n <= 0) {
+            std::fprintf(stderr, "send: %s\n", std::strerror(errno));
+            std::exit(1);
+        }
+        sent += n;
+    }
+}
+
+// Reads one Content-Length delimited response; bytes past it stay in `pending`.
+static void readResponse(int fd, std::string& pending) {
+    char buffer[65536];
+    size_t headEnd;
+    while ((headEnd = pending.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            std::fprintf(stderr, "connection closed by server\n");
+            std::exit(1);
+        }
+        pending.append(buffer, n);
+    }
+    size_t length = 0;
+    size_t field = pending.find("Content-Length:");
+    if (field != std::string::npos && field < headEnd) {
+        length = std::strtoul(pending.c_str() + field + 15, NULL, 10);
+    }
+    size_t total = headEnd + 4 + length;
+    while (pending.size() < total) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            std::fprintf(stderr, "connection closed by server\n");
+            std::exit(1);
+        }
+        pending.append(buffer, n);
+    }
+    pending.erase(0, total);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s IDLE [PORT] [SECONDS] [PATH]\n", argv[0]);
+        return 1;
+    }
+    int idle = std::atoi(argv[1]);
+    int port = argc > 2 ? std::atoi(argv[2]) : 8080;
+    double seconds = argc > 3 ? std::atof(argv[3]) : 3.0;
+    std::string request = "GET " + std::string(argc > 4 ? argv[4] : "/index.html")
+        + " HTTP/1.1\r\nHost: bench\r\n\r\n";
+
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    for (int i = 0; i < idle; ++i) {
+        sendAll(connectTo(port), request);
+    }
+    usleep(500000);
+
+    int fd = connectTo(port);
+    std::string pending;
+    long count = 0;
+    double start = now();
+    while (now() - start < seconds) {
+        sendAll(fd, request);
+        readResponse(fd, pending);
+        ++count;
+    }
+    std::printf("idle=%d req/s=%.0f\n", idle, count / (now() - start));
+    return 0;
+}
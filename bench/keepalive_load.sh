@@ -0,0 +1,28 @@
+#!/bin/sh
+# Request rate on one busy keep-alive connection while 0 to 9000 other
+# keep-alive connections sit idle; event dispatch cost shows up as a rate
+# that falls with the idle count.
+#
+# Run from the repository root after `make`:  sh bench/keepalive_load.sh
+# WEBSERV and PORT override the binary and the port (default 8091); the
+# server needs an open file limit above 9000 (ulimit -n).
+set -e
+
+WEBSERV=${WEBSERV:-./webserv}
+PORT=${PORT:-8091}
+WORK=$(mktemp -d)
+PID=
+trap '[ -n "$PID" ] && kill "$PID" 2>/dev/null; rm -rf "$WORK"' EXIT
+
+c++ -O2 -o "$WORK/keepalive_load" bench/keepalive_load.cpp
+sed -e "s|@PORT@|$PORT|" bench/keepalive.conf > "$WORK/keepalive.conf"
+
+for idle in 0 1000 5000 9000; do
+    "$WEBSERV" "$WORK/keepalive.conf" > /dev/null 2>&1 &
+    PID=$!
+    sleep 1
+    "$WORK/keepalive_load" "$idle" "$PORT" 3
+    kill "$PID"
+    wait "$PID" 2>/dev/null || true
+    PID=
+done
@@ -0,0 +1,14 @@
+#!/usr/bin/env python3
+# About 4.8 MB of text/plain CGI output, written in many small pieces.
+import random
+import sys
+
+rng = random.Random(42)
+words = ["alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel",
+         "india", "juliet", "kilo", "lima", "mike", "november", "oscar", "papa"]
+sys.stdout.write("Content-Type: text/plain\r\n\r\n")
+for i in range(60000):
+    line = " ".join(rng.choice(words) for _ in range(8))
+    sys.stdout.write("%06d %08x %s\n" % (i, rng.getrandbits(32), line))
+    if i % 500 == 0:
+        sys.stdout.flush()
@@ -11,4 +11,8 @@ bool setToNonBlocking(int fd);
 std::string numberToString(size_t number);
 std::string toLowerCase(const std::string& str);
 
+// RFC 1123 dates as used in HTTP headers ("Sun, 06 Nov 1994 08:49:37 GMT").
+std::string formatHttpDate(time_t when);
+bool parseHttpDate(const std::string& value, time_t& when);
+
 #endif // GLOBAL_UTILS_HPP
@@ -67,4 +67,12 @@ enum ConnectionState {
     CONNECTION_CLOSED
 };
 
+enum ClientTimeout {
+    TIMEOUT_NONE,
+    TIMEOUT_HEADER,
+    TIMEOUT_BODY,
+    TIMEOUT_KEEPALIVE,
+    TIMEOUT_SEND
+};
+
 #endif
\ No newline at end of file
@@ -5,35 +5,30 @@
 #include "../http/requestParse/Request.hpp"
 #include "../http/response/HttpMethodHandler.hpp"
 #include "../http/response/Response.hpp"
+#include "../http/response/ResponseCache.hpp"
+#include "../http/response/GzipEncoder.hpp"
+#include "../http/httpMethods/utils/ContentEncoding.hpp"
+#include "../http/requestParse/RequestParser.hpp"
+#include "../http/httpMethods/post/POSThandler.hpp"
+#include "../../include/GlobalUtils.hpp"
 
-static bool isCgiByExtension(const std::string& uri) {
-    std::string uriPath = uri;
-    size_t queryPos = uriPath.find('?');
-    if (queryPos != std::string::npos) {
-        uriPath = uriPath.substr(0, queryPos);
-    }
-    
-    const char* extensions[] = {".php", ".py", ".js", ".rb", ".pl", ".cgi", ".sh", NULL};
-    
-    for (int i = 0; extensions[i] != NULL; ++i) {
-        std::string ext = extensions[i];
-        if (uriPath.length() >= ext.length()) {
-            if (uriPath.substr(uriPath.length() - ext.length()) == ext) {
-                return true;
-            }
-        }
-    }
-    return false;
-}
+const size_t Client::MAX_PIPELINED_REQUESTS;
 
 Client::Client(int fd, ServerConfig* serverConfig) 
-    : fd(fd), state(READING_REQUEST), request(NULL), response(NULL),
-      bytes_read(0), bytes_written(0), last_activity(time(NULL)), 
-      serverConfig(serverConfig), eventManager(NULL), waitingForCgi(false) {
+    : EventSource(EVENT_CLIENT), fd(fd), state(READING_REQUEST), request(NULL), response(NULL),
+      parsing_request(NULL), error_response(NULL),
+      bytes_read(0),
+      serverConfig(serverConfig), eventManager(NULL), cgiExecution(NULL),
+      keep_alive(true), requests_served(0),
+      registered_events(EPOLLIN | EPOLLERR | EPOLLHUP), server_index(0),
+      timeout_phase(TIMEOUT_NONE) {
     if (fd <= 0) throw std::invalid_argument("Invalid file descriptor");
 }
 
 Client::~Client() {
+    if (eventManager) {
+        eventManager->getTimers().cancel(this);
+    }
     if (fd > 0) close(fd);
     if (request) {
         delete request;
@@ -41,199 +36,511 @@ Client::~Client() {
     if (response) {
         delete response;
     }
+    discardPendingRequests();
 }
 
-void Client::setCgiResponse(Response* res) {
-    
+void Client::discardPendingRequests() {
+    if (parsing_request) {
+        delete parsing_request;
+        parsing_request = NULL;
+    }
+    for (size_t i = 0; i < pending_requests.size(); ++i) {
+        delete pending_requests[i];
+    }
+    pending_requests.clear();
+    if (error_response) {
+        delete error_response;
+        error_response = NULL;
+    }
+}
+
+void Client::setResponse(Response* res) {
     if (response) {
         delete response;
     }
     response = res;
+}
+
+void Client::setCgiResponse(Response* res) {
     
-    if (response) {
-        write_buffer = response->toString();
-        
-        state = WRITING_RESPONSE;
-        
-        if (eventManager) {
-            eventManager->modifySocket(fd, this, EPOLLOUT | EPOLLERR | EPOLLHUP);
-        } else {
-            std::cerr << "[ERROR] EventManager not set in client!" << std::endl;
-        }
+    setResponse(res);
+    cgiExecution = NULL;
+    
+    if (state == CONNECTION_CLOSED) {
+        return;
     }
+    
+    finishResponse();
+    processQueue();
+    updateEvents();
 }
 
 void Client::handleRead(EventManager& event_mgr) {
 
     char buffer[8192];
+    size_t budget = event_mgr.getIoBudget();
+    size_t consumed = 0;
+    bool drained = false;
 
-    ssize_t bytes = recv(fd, buffer, sizeof(buffer), 0);
-
-    if (bytes > 0) {
-            last_activity = time(NULL);
+    while (!drained && consumed < budget) {
+        ssize_t bytes = recv(fd, buffer, sizeof(buffer), 0);
 
+        if (bytes > 0) {
             read_buffer.append(buffer, static_cast<size_t>(bytes));
             bytes_read += bytes;
+            consumed += bytes;
+            // A short read on a stream socket means the receive queue is empty.
+            drained = static_cast<size_t>(bytes) < sizeof(buffer);
+            continue;
+        }
+        if (bytes == 0) {
+            closeConnection(event_mgr);
+            return;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            closeConnection(event_mgr);
+            return;
+        }
+        drained = true;
     }
 
-    if (bytes == 0) {
-        closeConnection(event_mgr);
-        return;
+    parseRequests();
+    processQueue();
+    updateEvents(!drained);
+}
+
+void Client::parseRequests() {
+    
+    size_t offset = 0;
+    
+    while (keep_alive && !error_response && offset < read_buffer.size()
+           && pending_requests.size() < MAX_PIPELINED_REQUESTS) {
+        try {
+            if (!parsing_request) {
+                parsing_request = new Request(serverConfig->getClientBodyBufferSize(),
+                                              serverConfig->getClientBodyTempPath());
+            }
+            bool hadHead = parsing_request->isHeadComplete();
+            offset += parsing_request->consume(read_buffer.data() + offset, read_buffer.size() - offset);
+            if (!hadHead && parsing_request->isHeadComplete()) {
+                startRequestBody(*parsing_request, offset < read_buffer.size());
+            }
+            if (!parsing_request->isComplete()) {
+                continue;
+            }
+            
+            pending_requests.push_back(parsing_request);
+            parsing_request = NULL;
+        }
+        catch (const Request::PayloadTooLarge& e) {
+            delete parsing_request;
+            parsing_request = NULL;
+            offset = read_buffer.size();
+            error_response = Response::makeErrorResponse(413, serverConfig);
+            break;
+        }
+        catch (const Request::InvalidRequest& e) {
+            delete parsing_request;
+            parsing_request = NULL;
+            error_response = Response::makeErrorResponse(400, serverConfig);
+            break;
+        }
+        catch (const Request::NotSupportedRequest& e) {
+            delete parsing_request;
+            parsing_request = NULL;
+            error_response = Response::makeErrorResponse(501, serverConfig);
+            break;
+        }
+        catch (const std::exception& e) {
+            std::cerr << "[ERROR] " << e.what() << std::endl;
+            delete parsing_request;
+            parsing_request = NULL;
+            error_response = Response::makeErrorResponse(500, serverConfig);
+            break;
+        }
     }
+    read_buffer.erase(0, offset);
+}
 
-    if (bytes < 0) {
+// Runs once the head is parsed, before any body byte is taken. A body over
+// the location's limit is refused without being read (a chunked one as soon
+// as a chunk would cross it); an acceptable one may be answered
+// "100 Continue", and multipart uploads headed for a POST location are
+// parsed as they stream in, straight into the upload store.
+void Client::startRequestBody(Request& req, bool bodyBuffered) {
+    if (!req.hasBody()) {
         return;
     }
-    last_activity = time(NULL);
-
-    if (time(NULL) - last_activity > 30) {
-        std::cout << "[TIMEOUT] Client connection timed out after 30 seconds" << std::endl;
-        closeConnection(event_mgr);
+    
+    const LocationConfig* location = serverConfig->findLocation(req.getURI());
+    size_t limit = serverConfig->getClientMaxBodySize(location);
+    if (req.getExpectedBodySize() > limit) {
+        throw Request::PayloadTooLarge();
+    }
+    req.setBodyLimit(limit);
+    
+    // Only when nothing is queued ahead of this request, so the interim
+    // response cannot overtake the final response to an earlier one.
+    if (!bodyBuffered && !request && pending_requests.empty()
+        && req.getVersion() == "HTTP/1.1" && req.getHeader("Expect").equalsIgnoreCase("100-continue")) {
+        output.append("HTTP/1.1 100 Continue\r\n\r\n");
+    }
+    
+    std::string contentType = req.getHeader("Content-Type");
+    if (contentType.find("multipart/form-data") == std::string::npos) {
         return;
     }
-
-    if (state == READING_REQUEST) {
-        parseRequest();
+    const LocationConfig* postLocation = HttpMethodDispatcher::findPostLocation(req, *serverConfig);
+    std::string boundary = RequestParser::extractBoundary(contentType);
+    if (postLocation && !boundary.empty()) {
+        req.streamMultipart(boundary, POSThandler::getUploadDirectory(postLocation));
     }
+}
 
-    if (state == REQUEST_COMPLETE) {
-        buildResponse();
+void Client::processQueue() {
+    
+    while (!isWaitingForCgi() && keep_alive && !pending_requests.empty()) {
+        request = pending_requests.front();
+        pending_requests.pop_front();
         
-        if (waitingForCgi) {
-            return;
+        if (serveCachedResponse()) {
+            continue;
         }
+        buildResponse();
         
-        event_mgr.modifySocket(fd, this, EPOLLOUT | EPOLLERR | EPOLLHUP);
-        state = WRITING_RESPONSE;
-    } else if (state == REQUEST_ERROR) {
-        if (response) {
-            write_buffer = response->toString();
-        } else {
-            buildResponse();
+        if (isWaitingForCgi()) {
+            return;
         }
-        event_mgr.modifySocket(fd, this, EPOLLOUT | EPOLLERR | EPOLLHUP);
-        state = WRITING_RESPONSE;
+        finishResponse();
+    }
+    
+    if (!isWaitingForCgi() && keep_alive && error_response) {
+        keep_alive = false;
+        response = error_response;
+        error_response = NULL;
+        finishResponse();
+    }
+    
+    if (!keep_alive) {
+        discardPendingRequests();
     }
 }
 
+void Client::updateKeepAlive() {
+    if (!request || !request->isKeepAlive()
+        || serverConfig->getKeepAliveTimeout() == 0
+        || requests_served + 1 >= serverConfig->getKeepAliveRequests()) {
+        keep_alive = false;
+    }
+}
 
-void Client::handleWrite(EventManager& event_mgr)
-{
+void Client::prepareResponseHead() {
+    updateKeepAlive();
     
-    if (write_buffer.empty() || state != WRITING_RESPONSE)
-    {
-        return;
+    if (request && request->getVersion() == "HTTP/1.1") {
+        response->setVersion("HTTP/1.1");
+    }
+    response->setConnection(keep_alive ? "keep-alive" : "close");
+}
+
+void Client::finishResponse() {
+    if (!response) {
+        keep_alive = false;
+        response = Response::makeErrorResponse(500, serverConfig);
+    }
+    
+    prepareResponseHead();
+    if (request && response->getBodyPartCount() == 0) {
+        compressResponse();
+    }
+    
+    int status = response->getStatus();
+    std::map<std::string, std::string> headers = response->getHeaders();
+    if (headers.find("Content-Length") == headers.end() && status >= 200 && status != 204 && status != 304) {
+        response->addHeader("Content-Length", numberToString(response->getContentSize()));
     }
     
-    size_t remaining = write_buffer.length() - bytes_written;
+    if (!response->getCacheFilePath().empty() && status == 200 && headers.find("Vary") == headers.end()) {
+        ResponseCache::store(serverConfig, request->getURI(), response->serializeHeadFields(),
+                             response->getBodyBuffer(), response->getCacheFilePath());
+    }
+    output.append(response->serializeHead());
+    if (response->getBodyPartCount() == 0) {
+        output.append(response->getBodyBuffer());
+    }
+    for (size_t i = 0; i < response->getBodyPartCount(); ++i) {
+        const ResponseBodyPart& part = response->getBodyPart(i);
+        if (part.file.isOpen()) {
+            output.appendFile(part.file, part.offset, part.length);
+        } else {
+            output.append(part.buffer, static_cast<size_t>(part.offset), part.length);
+        }
+    }
+    ++requests_served;
     
-    ssize_t bytes = send(fd, write_buffer.c_str() + bytes_written, remaining, 0);
+    delete response;
+    response = NULL;
+    if (request) {
+        delete request;
+        request = NULL;
+    }
+}
+
+void Client::compressResponse() {
+    const SharedBuffer& body = response->getBodyBuffer();
+    unsigned accepted = ContentEncoding::accepted(request->getHeader("Accept-Encoding"));
+    int level = GzipEncoder::negotiate(accepted, serverConfig->findLocation(request->getURI()),
+                                       *response, body.size());
+    std::string compressed;
+    if (level == 0 || !GzipEncoder::compress(body.data(), body.size(), level, compressed)
+        || compressed.size() >= body.size()) {
+        return;
+    }
+    response->setBody(SharedBuffer::adopt(compressed));
+    response->addHeader("Content-Encoding", "gzip");
+    response->addHeader("Content-Length", numberToString(response->getContentSize()));
+}
+
+// Answers request straight from ResponseCache. Only the status line's
+// version and the Connection header are produced per request.
+bool Client::serveCachedResponse() {
+    if (!ResponseCache::enabled() || request->getMethod() != "GET"
+        || request->hasHeader("If-None-Match") || request->hasHeader("If-Modified-Since")
+        || request->hasHeader("Range")) {
+        return false;
+    }
+    BufferView version = request->getVersion();
+    if (version != "HTTP/1.1" && version != "HTTP/1.0") {
+        return false;
+    }
+    const ResponseCache::Entry* cached = ResponseCache::lookup(serverConfig, request->getURI());
+    if (!cached) {
+        return false;
+    }
     
+    updateKeepAlive();
+    output.append(version.data(), version.size());
+    output.append(cached->head);
+    output.append(keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n");
+    output.append(cached->body);
+    ++requests_served;
+    delete request;
+    request = NULL;
+    return true;
+}
+
+// A streamed response is sent as its head followed by body data appended as
+// it is produced; the body framing (Content-Length, chunked, or end at close)
+// is the producer's job. closeAfter is set when the end of the body can only
+// be signalled by closing the connection.
+void Client::beginStreamedResponse(Response* head, bool closeAfter) {
+    setResponse(head);
+    if (closeAfter) {
+        keep_alive = false;
+    }
+    prepareResponseHead();
+    output.append(response->serializeHead());
     
-    last_activity = time(NULL);
+    delete response;
+    response = NULL;
+    updateEvents();
+}
+
+void Client::appendResponseData(const char* data, size_t size) {
+    output.append(data, size);
+    updateEvents();
+}
+
+// An incomplete body cannot be repaired once the head is out, so the
+// connection is closed after what was produced has been sent.
+void Client::endStreamedResponse(bool complete) {
+    cgiExecution = NULL;
+    if (!complete) {
+        keep_alive = false;
+    }
+    ++requests_served;
+    if (request) {
+        delete request;
+        request = NULL;
+    }
     
-    if (bytes < 0)
-    {
+    if (state == CONNECTION_CLOSED || !eventManager) {
+        return;
+    }
+    if (!keep_alive && !hasPendingOutput()) {
+        closeConnection(*eventManager);
+        return;
+    }
+    processQueue();
+    updateEvents();
+}
+
+// With rearm set the registration is refreshed even if the mask is unchanged,
+// so that an edge-triggered socket left unread by the I/O budget is reported
+// again on the next wakeup instead of stalling.
+void Client::updateEvents(bool rearm) {
+    if (state == CONNECTION_CLOSED || !eventManager) {
         return;
     }
     
-    if (bytes == 0)
-    {
+    uint32_t wanted = EPOLLERR | EPOLLHUP;
+    if (hasPendingOutput()) {
+        wanted |= EPOLLOUT;
+        state = WRITING_RESPONSE;
+    } else {
+        if (keep_alive && pending_requests.size() < MAX_PIPELINED_REQUESTS) {
+            wanted |= EPOLLIN;
+        }
+        state = READING_REQUEST;
+    }
+    
+    if (wanted != registered_events || (rearm && eventManager->isEdgeTriggered())) {
+        eventManager->modifySocket(fd, this, wanted);
+        registered_events = wanted;
+    }
+    updateTimer();
+}
+
+// Picks the deadline that applies to what the connection is waiting for.
+// The header deadline runs from the first byte of a request and is not
+// extended by trickled input; body and send deadlines restart on progress.
+void Client::updateTimer() {
+    if (!eventManager) {
         return;
     }
+    TimerWheel& timers = eventManager->getTimers();
     
-    bytes_written += bytes;
+    ClientTimeout phase = TIMEOUT_NONE;
+    size_t seconds = 0;
+    if (state == CONNECTION_CLOSED) {
+        phase = TIMEOUT_NONE;
+    } else if (hasPendingOutput()) {
+        phase = TIMEOUT_SEND;
+        seconds = serverConfig->getSendTimeout();
+    } else if (isWaitingForCgi() || !pending_requests.empty()) {
+        phase = TIMEOUT_NONE;
+    } else if (parsing_request && parsing_request->isHeadComplete()) {
+        phase = TIMEOUT_BODY;
+        seconds = serverConfig->getClientBodyTimeout();
+    } else if (parsing_request || !read_buffer.empty() || requests_served == 0) {
+        phase = TIMEOUT_HEADER;
+        seconds = serverConfig->getClientHeaderTimeout();
+    } else {
+        phase = TIMEOUT_KEEPALIVE;
+        seconds = serverConfig->getKeepAliveTimeout();
+    }
     
-    if (bytes_written >= write_buffer.length())
-    {
-        closeConnection(event_mgr);
+    bool restart = phase != timeout_phase || phase == TIMEOUT_SEND || phase == TIMEOUT_BODY;
+    timeout_phase = phase;
+    if (seconds == 0) {
+        timers.cancel(this);
+    } else if (restart || !timer.armed) {
+        timers.schedule(this, TimerWheel::now() + static_cast<long>(seconds) * 1000L);
     }
 }
 
-void Client::closeConnection(EventManager& event_mgr) {
-    if (fd > 0) {
-        event_mgr.removeSocket(fd);
-        close(fd);
-        fd = -1;
+void Client::handleTimeout(EventManager& event_mgr) {
+    if (state == CONNECTION_CLOSED) {
+        return;
     }
-    state = CONNECTION_CLOSED;
+    
+    if ((timeout_phase == TIMEOUT_HEADER || timeout_phase == TIMEOUT_BODY)
+        && (parsing_request || !read_buffer.empty())) {
+        std::cout << "[TIMEOUT] Request on fd=" << fd << " not received in time" << std::endl;
+        read_buffer.clear();
+        delete parsing_request;
+        parsing_request = NULL;
+        keep_alive = false;
+        setResponse(Response::makeErrorResponse(408, serverConfig));
+        finishResponse();
+        updateEvents();
+        return;
+    }
+    closeConnection(event_mgr);
 }
 
-void Client::parseRequest() {
+
+void Client::handleWrite(EventManager& event_mgr)
+{
     
-    try {
-        request = new Request(read_buffer);
+    if (!hasPendingOutput() || state != WRITING_RESPONSE)
+    {
+        return;
+    }
+    
+    size_t budget = event_mgr.getIoBudget();
+    size_t sent = 0;
+    
+    while (hasPendingOutput())
+    {
+        if (sent >= budget)
+        {
+            updateEvents(true);
+            return;
+        }
         
-        size_t max_body_size = serverConfig->getClientMaxBodySize();
-        size_t actual_body_size = request->getRawBody().size();
+        size_t attempted;
+        ssize_t bytes = output.send(fd, budget - sent, attempted);
         
-        if (actual_body_size > max_body_size) {
-            
-            delete request;
-            request = NULL;
-            
-            response = Response::makeErrorResponse(413, serverConfig);
-            if (!response) {
-                response = new Response();
-                response->setStatus(413);
-                response->setBody("<html><body><h1>413 Request Entity Too Large</h1></body></html>");
-                response->addHeader("Content-Type", "text/html");
-                {
-                    std::ostringstream oss;
-                    oss << response->getBody().size();
-                    response->addHeader("Content-Length", oss.str());
-                }
-            }
-            response->setConnection("close");
-            
-            state = REQUEST_ERROR;
+        if (bytes < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                closeConnection(event_mgr);
+            return;
+        }
+        // A file shrank under us; the promised length can no longer be met.
+        if (bytes == 0)
+        {
+            closeConnection(event_mgr);
             return;
         }
         
+        sent += bytes;
+        if (static_cast<size_t>(bytes) < attempted)
+        {
+            updateTimer();
+            return;
+        }
+        if (hasPendingOutput())
+            continue;
         
-        state = REQUEST_COMPLETE;
-    }
-    catch (const Request::IncompleteRequest& e) {
-        
-        if (request) {
-            std::map<std::string, std::string> headers = request->getHeaders();
-            std::map<std::string, std::string>::iterator cl_it = headers.find("Content-Length");
-            
-            if (cl_it != headers.end()) {
-                size_t content_length = std::atol(cl_it->second.c_str());
-                size_t max_body_size = serverConfig->getClientMaxBodySize();
-                
-                if (content_length > max_body_size) {
-                    delete request;
-                    request = NULL;
-                    
-                    response = Response::makeErrorResponse(413, serverConfig);
-                    if (!response) {
-                        response = new Response();
-                        response->setStatus(413);
-                        response->setBody("<html><body><h1>413 Request Entity Too Large</h1></body></html>");
-                        response->addHeader("Content-Type", "text/html");
-                        std::ostringstream oss;
-                        oss << response->getBody().size();
-                        response->addHeader("Content-Length", oss.str());
-                    }
-                    response->setConnection("close");
-                    
-                    state = REQUEST_ERROR;
-                }
-            }
+        if (cgiExecution) {
+            CGIhandler::resumeCgiOutput(cgiExecution, event_mgr);
         }
-        return;
+        if (!keep_alive && !isWaitingForCgi()) {
+            closeConnection(event_mgr);
+            return;
+        }
+        
+        parseRequests();
+        processQueue();
     }
-    catch (const std::exception& e) {
-        state = REQUEST_ERROR;
+    updateEvents();
+}
+
+void Client::closeConnection(EventManager& event_mgr) {
+    event_mgr.getTimers().cancel(this);
+    if (cgiExecution) {
+        CGIhandler::abortCgiExecution(cgiExecution, event_mgr);
+        cgiExecution = NULL;
     }
+    if (fd > 0) {
+        event_mgr.removeSocket(fd);
+        close(fd);
+        fd = -1;
+    }
+    output.clear();
+    state = CONNECTION_CLOSED;
 }
 
 void Client::buildResponse() {
     
     if (!request) {
-        state = REQUEST_ERROR;
         return;
     }
     
@@ -253,7 +560,7 @@ void Client::buildResponse() {
             }
         }
         
-        if (location && location->isCGIEnabled() && eventManager && isCgiByExtension(uri)) {
+        if (location && location->isCGIEnabled() && eventManager && CGIhandler::isCgiByExtension(uri)) {
             
             if (CGIhandler::startCgiExecution(*request, location, serverConfig, this, *eventManager)) {
                 return;
@@ -268,32 +575,24 @@ void Client::buildResponse() {
             response = Response::makeErrorResponse(500, serverConfig);
         }
         
-        response->setConnection("close");
-        write_buffer = response->toString();
-        
     } catch (const std::bad_alloc& e) {
         std::cerr << "[ERROR] Memory allocation failed: " << e.what() << std::endl;
         if (!response) {
             response = Response::makeErrorResponse(500, serverConfig);
-            write_buffer = response->toString();
         }
-        state = REQUEST_ERROR;
+        keep_alive = false;
     } catch (const std::exception& e) {
         std::cerr << "[ERROR] Exception: " << e.what() << std::endl;
         if (!response) {
             response = Response::makeErrorResponse(500, serverConfig);
-            write_buffer = response->toString();
         }
-        state = REQUEST_ERROR;
+        keep_alive = false;
     } catch (...) {
+        keep_alive = false;
         try {
             response = Response::makeErrorResponse(500, serverConfig);
-            response->setConnection("close");
-            write_buffer = response->toString();
         } catch (...) {
-            write_buffer = "HTTP/1.0 500 Internal Server Error\r\n"
-                          "Content-Length: 0\r\n"
-                          "Connection: close\r\n\r\n";
+            response = NULL;
         }
     }
 }
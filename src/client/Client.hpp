@@ -6,38 +6,68 @@
 #include "../config/LocationConfig.hpp"
 #include "../http/requestParse/Request.hpp"
 #include "../http/response/Response.hpp"
-#include "../http/httpMethods/cgi/CGIhandler.hpp" 
+#include "../http/httpMethods/cgi/CGIhandler.hpp"
+#include "../server/EventSource.hpp"
+#include "OutputQueue.hpp"
+#include <deque>
 
 class EventManager;
 
-class Client {
+class Client : public EventSource {
 private:
     int fd;
     ConnectionState state;
     Request* request;
     Response* response;
+    Request* parsing_request;
+    std::deque<Request*> pending_requests;
+    Response* error_response;
     std::string read_buffer;
-    std::string write_buffer;
+    OutputQueue output;
     size_t bytes_read;
-    size_t bytes_written;
-    time_t last_activity;
     ServerConfig* serverConfig;
     EventManager* eventManager;
-    bool waitingForCgi;
+    CgiExecution* cgiExecution;
+    bool keep_alive;
+    size_t requests_served;
+    uint32_t registered_events;
+    size_t server_index;
+    ClientTimeout timeout_phase;
+
+    static const size_t MAX_PIPELINED_REQUESTS = 32;
+
+    void parseRequests();
+    void startRequestBody(Request& req, bool bodyBuffered);
+    void processQueue();
+    void updateKeepAlive();
+    bool serveCachedResponse();
+    void prepareResponseHead();
+    void compressResponse();
+    void finishResponse();
+    void updateEvents(bool rearm = false);
+    bool hasPendingOutput() const { return !output.empty(); }
+    void discardPendingRequests();
 public:
     Client(int fd, ServerConfig* serverConfig);
     virtual ~Client();
     void handleRead(EventManager& event_mgr);
     void handleWrite(EventManager& event_mgr);
     void closeConnection(EventManager& event_mgr);
-    void parseRequest();
     void buildResponse();
-    void setWaitingForCgi(bool waiting) { waitingForCgi = waiting; }
-    bool isWaitingForCgi() const { return waitingForCgi; }
+    void setCgiExecution(CgiExecution* exec) { cgiExecution = exec; }
+    bool isWaitingForCgi() const { return cgiExecution != NULL; }
     void setCgiResponse(Response* res);
+    void setResponse(Response* res);
+    void beginStreamedResponse(Response* head, bool closeAfter);
+    void appendResponseData(const char* data, size_t size);
+    void endStreamedResponse(bool complete);
+    size_t getPendingOutput() const { return output.size(); }
     void setEventManager(EventManager* mgr) { eventManager = mgr; }
-    
+    bool isClosed() const { return state == CONNECTION_CLOSED; }
+    void updateTimer();
+    void handleTimeout(EventManager& event_mgr);
+    void setServerIndex(size_t index) { server_index = index; }
+    size_t getServerIndex() const { return server_index; }
 };
 
 #endif
-
@@ -0,0 +1,144 @@
+#include "OutputQueue.hpp"
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+const size_t OutputQueue::MAX_IOV;
+const size_t OutputQueue::MIN_SHARED_SIZE;
+
+OutputQueue::OutputQueue() : pending(0) {}
+
+OutputQueue::~OutputQueue() {
+    clear();
+}
+
+void OutputQueue::clear() {
+    while (!segments.empty()) {
+        popFront();
+    }
+    pending = 0;
+}
+
+void OutputQueue::popFront() {
+    segments.pop_front();
+}
+
+void OutputQueue::append(const char* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    // A segment already being sent is not extended, or a steady producer
+    // would keep its sent prefix alive until the queue fully drains.
+    if (segments.empty() || segments.back().type != SEGMENT_OWNED || segments.back().sent > 0) {
+        segments.push_back(Segment());
+    }
+    Segment& tail = segments.back();
+    tail.owned.append(data, size);
+    tail.length += size;
+    pending += size;
+}
+
+// Queues bytes [offset, offset + length) of buffer.
+void OutputQueue::append(const SharedBuffer& buffer, size_t offset, size_t length) {
+    if (length < MIN_SHARED_SIZE) {
+        append(buffer.data() + offset, length);
+        return;
+    }
+    segments.push_back(Segment());
+    Segment& tail = segments.back();
+    tail.type = SEGMENT_SHARED;
+    tail.shared = buffer;
+    tail.sharedOffset = offset;
+    tail.length = length;
+    pending += length;
+}
+
+// Queues bytes [offset, offset + length) of file. The descriptor is closed
+// once neither the queue nor anyone else holds it.
+void OutputQueue::appendFile(const SharedFile& file, off_t offset, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    segments.push_back(Segment());
+    Segment& tail = segments.back();
+    tail.type = SEGMENT_FILE;
+    tail.file = file;
+    tail.fileOffset = offset;
+    tail.length = length;
+    pending += length;
+}
+
+// Sends at most limit bytes from the front of the queue. attempted is set to
+// the number of bytes offered to the kernel, so a result below it means the
+// socket buffer is full. A result of 0 means a file ended before its declared
+// length.
+ssize_t OutputQueue::send(int sock, size_t limit, size_t& attempted) {
+    attempted = 0;
+    if (segments.empty() || limit == 0) {
+        return 0;
+    }
+    if (segments.front().type == SEGMENT_FILE) {
+        return sendFile(sock, limit, attempted);
+    }
+    return sendMemory(sock, limit, attempted);
+}
+
+ssize_t OutputQueue::sendMemory(int sock, size_t limit, size_t& attempted) {
+    struct iovec iov[MAX_IOV];
+    size_t count = 0;
+    bool fileFollows = false;
+    
+    for (std::deque<Segment>::iterator it = segments.begin();
+         it != segments.end() && count < MAX_IOV && attempted < limit; ++it) {
+        if (it->type == SEGMENT_FILE) {
+            fileFollows = true;
+            break;
+        }
+        const char* base = (it->type == SEGMENT_OWNED) ? it->owned.data()
+                                                       : it->shared.data() + it->sharedOffset;
+        size_t length = std::min(it->length - it->sent, limit - attempted);
+        iov[count].iov_base = const_cast<char*>(base + it->sent);
+        iov[count].iov_len = length;
+        attempted += length;
+        ++count;
+    }
+    
+    struct msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    // MSG_MORE lets a head share a segment with the file data after it.
+    ssize_t bytes = sendmsg(sock, &msg, MSG_NOSIGNAL | (fileFollows ? MSG_MORE : 0));
+    if (bytes <= 0) {
+        return bytes;
+    }
+    
+    size_t left = static_cast<size_t>(bytes);
+    pending -= left;
+    while (left > 0) {
+        Segment& front = segments.front();
+        size_t take = std::min(front.length - front.sent, left);
+        front.sent += take;
+        left -= take;
+        if (front.sent == front.length) {
+            popFront();
+        }
+    }
+    return bytes;
+}
+
+ssize_t OutputQueue::sendFile(int sock, size_t limit, size_t& attempted) {
+    Segment& front = segments.front();
+    attempted = std::min(front.length - front.sent, limit);
+    ssize_t bytes = sendfile(sock, front.file.fd(), &front.fileOffset, attempted);
+    if (bytes <= 0) {
+        return bytes;
+    }
+    front.sent += bytes;
+    pending -= bytes;
+    if (front.sent == front.length) {
+        popFront();
+    }
+    return bytes;
+}
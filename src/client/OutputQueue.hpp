@@ -0,0 +1,65 @@
+#ifndef OUTPUT_QUEUE_HPP
+#define OUTPUT_QUEUE_HPP
+
+#include "../../include/webserv.hpp"
+#include "../http/response/SharedBuffer.hpp"
+#include "../http/response/SharedFile.hpp"
+#include <deque>
+
+// Bytes waiting to be sent on a connection, as a list of segments: small
+// pieces (response heads, CGI output) are copied into an owned buffer,
+// bodies are referenced as shared buffers or open files. Memory segments
+// are written with one sendmsg() per call, files with sendfile().
+class OutputQueue {
+private:
+    enum SegmentType {
+        SEGMENT_OWNED,
+        SEGMENT_SHARED,
+        SEGMENT_FILE
+    };
+
+    struct Segment {
+        SegmentType type;
+        std::string owned;
+        SharedBuffer shared;
+        size_t sharedOffset;
+        SharedFile file;
+        off_t fileOffset;
+        size_t length;
+        size_t sent;
+
+        Segment() : type(SEGMENT_OWNED), sharedOffset(0), fileOffset(0), length(0), sent(0) {}
+    };
+
+    static const size_t MAX_IOV = 64;
+    // Shared bodies smaller than this are copied next to their head instead,
+    // which keeps the iovec count down for small responses.
+    static const size_t MIN_SHARED_SIZE = 4096;
+
+    std::deque<Segment> segments;
+    size_t pending;
+
+    OutputQueue(const OutputQueue&);
+    OutputQueue& operator=(const OutputQueue&);
+
+    void popFront();
+    ssize_t sendMemory(int sock, size_t limit, size_t& attempted);
+    ssize_t sendFile(int sock, size_t limit, size_t& attempted);
+
+public:
+    OutputQueue();
+    ~OutputQueue();
+
+    void append(const char* data, size_t size);
+    void append(const std::string& data) { append(data.data(), data.size()); }
+    void append(const SharedBuffer& buffer) { append(buffer, 0, buffer.size()); }
+    void append(const SharedBuffer& buffer, size_t offset, size_t length);
+    void appendFile(const SharedFile& file, off_t offset, size_t length);
+
+    ssize_t send(int sock, size_t limit, size_t& attempted);
+    size_t size() const { return pending; }
+    bool empty() const { return pending == 0; }
+    void clear();
+};
+
+#endif
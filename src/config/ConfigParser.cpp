@@ -227,6 +227,46 @@ LocationConfig		ConfigParser::makeLocationConfig(std::vector<std::string>::itera
 				throw std::runtime_error("Config parse error: 'upload_store' directive accepts only one value, found extra: '" + *tokens + "'");
 			}
 			if (tokens != tokensEnd && *tokens == ";") tokens++;
+        }
+        else if (*tokens == "gzip") {
+            tokens++;
+			if (tokens == tokensEnd || (*tokens != "on" && *tokens != "off")) {
+				throw std::runtime_error("Config parse error: 'gzip' directive in location '" + outputLocation.getPath() + "' requires exactly one value (on/off)");
+			}
+            outputLocation.setGzip(*tokens == "on");
+			tokens++;
+			if (tokens == tokensEnd || *tokens != ";") {
+				throw std::runtime_error("Config parse error: 'gzip' directive accepts only one value");
+			}
+			tokens++;
+        }
+        else if (*tokens == "gzip_types") {
+            tokens++;
+            std::vector<std::string> types;
+            while (tokens != tokensEnd && *tokens != ";" && *tokens != "}") {
+                types.push_back(*(tokens++));
+            }
+			if (types.empty() || tokens == tokensEnd || *tokens != ";") {
+				throw std::runtime_error("Config parse error: 'gzip_types' directive in location '" + outputLocation.getPath() + "' requires at least one MIME type");
+			}
+            outputLocation.setGzipTypes(types);
+			tokens++;
+        }
+        else if (*tokens == "gzip_min_length" || *tokens == "gzip_comp_level") {
+            std::string directive = *(tokens++);
+			if (tokens == tokensEnd || *tokens == ";" || *tokens == "}" || (tokens + 1) == tokensEnd || *(tokens + 1) != ";") {
+				throw std::runtime_error("Config parse error: '" + directive + "' directive in location '" + outputLocation.getPath() + "' requires exactly one value");
+			}
+            if (directive == "gzip_min_length") {
+                outputLocation.setGzipMinLength(ParseUtils::parseMaxBodySize(*tokens));
+            } else {
+                int level = ParseUtils::toInt(tokens);
+                if (level < 1 || level > 9) {
+                    throw std::runtime_error("Config parse error: 'gzip_comp_level' must be between 1 and 9");
+                }
+                outputLocation.setGzipCompLevel(level);
+            }
+			tokens += 2;
         }
 		else if (*tokens == ";") {
 			tokens++;
@@ -353,6 +393,69 @@ while (it != end) {
         if (it != end && *it == ";") ++it;
         continue;
     }
+    else if (*it == "client_body_buffer_size") {
+        ++it;
+        if (it == end || *it == ";") {
+            throw std::runtime_error("Config parse error: 'client_body_buffer_size' directive requires exactly one value");
+        }
+        std::string sizeValue = *it;
+        ++it;
+        if (it != end && *it != ";") {
+            throw std::runtime_error("Config parse error: 'client_body_buffer_size' directive accepts only one value, found extra: '" + *it + "'");
+        }
+        try {
+            outputServer.setClientBodyBufferSize(ParseUtils::parseMaxBodySize(sizeValue));
+        } catch (const std::exception &e) {
+            throw std::runtime_error(std::string("Config parse error in server block (client_body_buffer_size): ") + e.what());
+        }
+        if (it != end && *it == ";") ++it;
+        continue;
+    }
+    else if (*it == "client_body_temp_path") {
+        ++it;
+        if (it == end || *it == ";") {
+            throw std::runtime_error("Config parse error: 'client_body_temp_path' directive requires exactly one value");
+        }
+        std::string path = *it;
+        ++it;
+        if (it != end && *it != ";") {
+            throw std::runtime_error("Config parse error: 'client_body_temp_path' directive accepts only one value, found extra: '" + *it + "'");
+        }
+        outputServer.setClientBodyTempPath(path);
+        if (it != end && *it == ";") ++it;
+        continue;
+    }
+    else if (*it == "keepalive_timeout" || *it == "keepalive_requests"
+             || *it == "client_header_timeout" || *it == "client_body_timeout"
+             || *it == "send_timeout" || *it == "cgi_timeout") {
+        std::string directive = *it;
+        ++it;
+        if (it == end || *it == ";") {
+            throw std::runtime_error("Config parse error: '" + directive + "' directive requires exactly one value");
+        }
+        int value = ParseUtils::toInt(it);
+        ++it;
+        if (it != end && *it != ";") {
+            throw std::runtime_error("Config parse error: '" + directive + "' directive accepts only one value, found extra: '" + *it + "'");
+        }
+        if (value < 0) {
+            throw std::runtime_error("Config parse error: '" + directive + "' value must not be negative");
+        }
+        if (directive == "keepalive_timeout")
+            outputServer.setKeepAliveTimeout(static_cast<size_t>(value));
+        else if (directive == "keepalive_requests")
+            outputServer.setKeepAliveRequests(static_cast<size_t>(value));
+        else if (directive == "client_header_timeout")
+            outputServer.setClientHeaderTimeout(static_cast<size_t>(value));
+        else if (directive == "client_body_timeout")
+            outputServer.setClientBodyTimeout(static_cast<size_t>(value));
+        else if (directive == "send_timeout")
+            outputServer.setSendTimeout(static_cast<size_t>(value));
+        else
+            outputServer.setCgiTimeout(static_cast<size_t>(value));
+        if (it != end && *it == ";") ++it;
+        continue;
+    }
     else if (*it == "error_page") {
         ++it;
         if (it == end || *it == ";") {
@@ -386,6 +489,84 @@ while (it != end) {
 	return (outputServer);
 }
 
+void ConfigParser::parseGlobalDirective(std::vector<std::string>::iterator &tokens, std::vector<std::string>::iterator tokensEnd) {
+    std::string directive = *tokens;
+    ++tokens;
+    if (tokens == tokensEnd || *tokens == ";") {
+        throw std::runtime_error("Config parse error: '" + directive + "' directive requires exactly one value");
+    }
+    std::string value = *tokens;
+    ++tokens;
+    if (tokens != tokensEnd && *tokens != ";") {
+        throw std::runtime_error("Config parse error: '" + directive + "' directive accepts only one value, found extra: '" + *tokens + "'");
+    }
+
+    if (directive == "worker_processes") {
+        int count;
+        if (value == "auto") {
+            count = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+        } else {
+            std::vector<std::string>::iterator valueIt = tokens - 1;
+            count = ParseUtils::toInt(valueIt);
+        }
+        if (count < 1) {
+            throw std::runtime_error("Config parse error: 'worker_processes' must be at least 1 or 'auto'");
+        }
+        global.setWorkerProcesses(count);
+    } else if (directive == "worker_cpu_affinity") {
+        if (value != "on" && value != "off") {
+            throw std::runtime_error("Config parse error: 'worker_cpu_affinity' value must be 'on' or 'off', got: '" + value + "'");
+        }
+        global.setWorkerCpuAffinity(value == "on");
+    } else if (directive == "edge_triggered") {
+        if (value != "on" && value != "off") {
+            throw std::runtime_error("Config parse error: 'edge_triggered' value must be 'on' or 'off', got: '" + value + "'");
+        }
+        global.setEdgeTriggered(value == "on");
+    } else if (directive == "io_budget") {
+        size_t budget = ParseUtils::parseMaxBodySize(value);
+        if (budget == 0) {
+            throw std::runtime_error("Config parse error: 'io_budget' must be greater than 0");
+        }
+        global.setIoBudget(budget);
+    } else if (directive == "event_batch_size") {
+        std::vector<std::string>::iterator valueIt = tokens - 1;
+        int size = ParseUtils::toInt(valueIt);
+        if (size < 1) {
+            throw std::runtime_error("Config parse error: 'event_batch_size' must be at least 1");
+        }
+        global.setEventBatchSize(size);
+    } else if (directive == "event_stats_interval") {
+        std::vector<std::string>::iterator valueIt = tokens - 1;
+        int seconds = ParseUtils::toInt(valueIt);
+        if (seconds < 0) {
+            throw std::runtime_error("Config parse error: 'event_stats_interval' must be a non-negative integer");
+        }
+        global.setEventStatsInterval(seconds);
+    } else if (directive == "file_cache_max_bytes") {
+        global.setFileCacheMaxBytes(ParseUtils::parseMaxBodySize(value));
+    } else if (directive == "file_cache_valid") {
+        std::vector<std::string>::iterator valueIt = tokens - 1;
+        int milliseconds = ParseUtils::toInt(valueIt);
+        if (milliseconds < 0) {
+            throw std::runtime_error("Config parse error: 'file_cache_valid' must be a non-negative number of milliseconds");
+        }
+        global.setFileCacheValid(milliseconds);
+    } else if (directive == "response_cache_max_bytes") {
+        global.setResponseCacheMaxBytes(ParseUtils::parseMaxBodySize(value));
+    } else if (directive == "gzip_cpu_budget") {
+        std::vector<std::string>::iterator valueIt = tokens - 1;
+        int percent = ParseUtils::toInt(valueIt);
+        if (percent < 0 || percent > 100) {
+            throw std::runtime_error("Config parse error: 'gzip_cpu_budget' must be a percentage between 0 and 100");
+        }
+        global.setGzipCpuBudget(percent);
+    } else if (directive == "listing_cache_max_bytes") {
+        global.setListingCacheMaxBytes(ParseUtils::parseMaxBodySize(value));
+    }
+    if (tokens != tokensEnd && *tokens == ";") ++tokens;
+}
+
 void ConfigParser::parse(std::string config_file) {
     try {
         std::vector<std::string> configFileData = ParseUtils::readFile(config_file);
@@ -401,6 +582,15 @@ void ConfigParser::parse(std::string config_file) {
                 if (it == before) ++it;
                 continue;
             }
+            if (*it == "worker_processes" || *it == "worker_cpu_affinity"
+                || *it == "edge_triggered" || *it == "io_budget"
+                || *it == "event_batch_size" || *it == "event_stats_interval"
+                || *it == "file_cache_max_bytes" || *it == "file_cache_valid"
+                || *it == "response_cache_max_bytes" || *it == "gzip_cpu_budget"
+                || *it == "listing_cache_max_bytes") {
+                parseGlobalDirective(it, end);
+                continue;
+            }
             ++it;
         }
         for (size_t i = 0; i < serversBlocks.size(); ++i)
@@ -414,3 +604,7 @@ void ConfigParser::parse(std::string config_file) {
 std::vector<ServerConfig> ConfigParser::getServers() const {
 	return (this->servers);
 }
+
+GlobalConfig ConfigParser::getGlobalConfig() const {
+	return (this->global);
+}
@@ -3,11 +3,15 @@
 #include "../../include/webserv.hpp"
 #include "ServerConfig.hpp"
 #include "ParsingBlock.hpp"
+#include "GlobalConfig.hpp"
 
 class ConfigParser {
 	private:
 		std::string 				config_file;
 		std::vector<ServerConfig> 	servers;
+		GlobalConfig				global;
+
+		void						parseGlobalDirective(std::vector<std::string>::iterator &tokens, std::vector<std::string>::iterator tokensEnd);
 
 		static	ParsingBlock 		makeServerBlock(std::vector<std::string>::iterator &tokens, std::vector<std::string>::iterator tokensEnd);
 		static	ParsingBlock 		makeLocationBlock(std::vector<std::string>::iterator &tokens);
@@ -16,4 +20,5 @@ class ConfigParser {
 	public:
 		void						parse(std::string config_file);
 		std::vector<ServerConfig> 	getServers() const;
+		GlobalConfig				getGlobalConfig() const;
 };
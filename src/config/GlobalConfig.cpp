@@ -0,0 +1,95 @@
+#include "GlobalConfig.hpp"
+
+GlobalConfig::GlobalConfig() : worker_processes(1), worker_cpu_affinity(false),
+	edge_triggered(false), io_budget(256 * 1024),
+	event_batch_size(512), event_stats_interval(0),
+	file_cache_max_bytes(0), file_cache_valid(1000), response_cache_max_bytes(0),
+	gzip_cpu_budget(50), listing_cache_max_bytes(0) {}
+
+void	GlobalConfig::setWorkerProcesses(int count) {
+	worker_processes = count;
+}
+
+void	GlobalConfig::setWorkerCpuAffinity(bool enabled) {
+	worker_cpu_affinity = enabled;
+}
+
+int		GlobalConfig::getWorkerProcesses() const {
+	return (this->worker_processes);
+}
+
+bool	GlobalConfig::getWorkerCpuAffinity() const {
+	return (this->worker_cpu_affinity);
+}
+
+void	GlobalConfig::setEdgeTriggered(bool enabled) {
+	edge_triggered = enabled;
+}
+
+void	GlobalConfig::setIoBudget(size_t bytes) {
+	io_budget = bytes;
+}
+
+void	GlobalConfig::setEventBatchSize(int size) {
+	event_batch_size = size;
+}
+
+void	GlobalConfig::setEventStatsInterval(int seconds) {
+	event_stats_interval = seconds;
+}
+
+void	GlobalConfig::setFileCacheMaxBytes(size_t bytes) {
+	file_cache_max_bytes = bytes;
+}
+
+void	GlobalConfig::setFileCacheValid(int milliseconds) {
+	file_cache_valid = milliseconds;
+}
+
+void	GlobalConfig::setResponseCacheMaxBytes(size_t bytes) {
+	response_cache_max_bytes = bytes;
+}
+
+void	GlobalConfig::setGzipCpuBudget(int percent) {
+	gzip_cpu_budget = percent;
+}
+
+void	GlobalConfig::setListingCacheMaxBytes(size_t bytes) {
+	listing_cache_max_bytes = bytes;
+}
+
+bool	GlobalConfig::getEdgeTriggered() const {
+	return (this->edge_triggered);
+}
+
+size_t	GlobalConfig::getIoBudget() const {
+	return (this->io_budget);
+}
+
+int		GlobalConfig::getEventBatchSize() const {
+	return (this->event_batch_size);
+}
+
+int		GlobalConfig::getEventStatsInterval() const {
+	return (this->event_stats_interval);
+}
+
+size_t	GlobalConfig::getFileCacheMaxBytes() const {
+	return (this->file_cache_max_bytes);
+}
+
+int		GlobalConfig::getFileCacheValid() const {
+	return (this->file_cache_valid);
+}
+
+size_t	GlobalConfig::getResponseCacheMaxBytes() const {
+	return (this->response_cache_max_bytes);
+}
+
+int		GlobalConfig::getGzipCpuBudget() const {
+	return (this->gzip_cpu_budget);
+}
+
+size_t	GlobalConfig::getListingCacheMaxBytes() const {
+	return (this->listing_cache_max_bytes);
+}
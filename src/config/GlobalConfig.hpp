@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../../include/webserv.hpp"
+
+class GlobalConfig {
+	private:
+		int		worker_processes;
+		bool	worker_cpu_affinity;
+		bool	edge_triggered;
+		size_t	io_budget;
+		int		event_batch_size;
+		int		event_stats_interval;
+		size_t	file_cache_max_bytes;
+		int		file_cache_valid;
+		size_t	response_cache_max_bytes;
+		int		gzip_cpu_budget;
+		size_t	listing_cache_max_bytes;
+
+	public:
+		GlobalConfig();
+		void	setWorkerProcesses(int count);
+		void	setWorkerCpuAffinity(bool enabled);
+		void	setEdgeTriggered(bool enabled);
+		void	setIoBudget(size_t bytes);
+		void	setEventBatchSize(int size);
+		void	setEventStatsInterval(int seconds);
+		void	setFileCacheMaxBytes(size_t bytes);
+		void	setFileCacheValid(int milliseconds);
+		void	setResponseCacheMaxBytes(size_t bytes);
+		void	setGzipCpuBudget(int percent);
+		void	setListingCacheMaxBytes(size_t bytes);
+
+		int		getWorkerProcesses() const;
+		bool	getWorkerCpuAffinity() const;
+		bool	getEdgeTriggered() const;
+		size_t	getIoBudget() const;
+		int		getEventBatchSize() const;
+		int		getEventStatsInterval() const;
+		size_t	getFileCacheMaxBytes() const;
+		int		getFileCacheValid() const;
+		size_t	getResponseCacheMaxBytes() const;
+		int		getGzipCpuBudget() const;
+		size_t	getListingCacheMaxBytes() const;
+};
@@ -1,8 +1,17 @@
 #include "LocationConfig.hpp"
 #include <iostream>
+#include <strings.h>
 
-LocationConfig::LocationConfig() : cgi_enabled(false), client_max_body_size(1024 * 1024), autoindex(false), 
-                                   has_return(false), return_code(0) {}
+LocationConfig::LocationConfig() : cgi_enabled(false), client_max_body_size(1024 * 1024),
+                                   has_client_max_body_size(false), autoindex(false), 
+                                   has_return(false), return_code(0), gzip(false),
+                                   gzip_min_length(1024), gzip_comp_level(1) {
+	gzip_types.push_back("text/html");
+	gzip_types.push_back("text/plain");
+	gzip_types.push_back("text/css");
+	gzip_types.push_back("application/javascript");
+	gzip_types.push_back("application/json");
+}
 
 void	LocationConfig::setPath(std::string pathStr) {
 	path = pathStr;
@@ -30,6 +39,7 @@ void	LocationConfig::setAutoIndex(bool autoindex) {
 
 void	LocationConfig::setClientMaxBodySize(size_t size) {
 	client_max_body_size = size;
+	has_client_max_body_size = true;
 }
 
 void	LocationConfig::setReturn(int code, const std::string& url) {
@@ -47,6 +57,22 @@ void	LocationConfig::setUploadStore(const std::string& path) {
 	upload_store = path;
 }
 
+void	LocationConfig::setGzip(bool state) {
+	gzip = state;
+}
+
+void	LocationConfig::setGzipTypes(const std::vector<std::string>& types) {
+	gzip_types = types;
+}
+
+void	LocationConfig::setGzipMinLength(size_t length) {
+	gzip_min_length = length;
+}
+
+void	LocationConfig::setGzipCompLevel(int level) {
+	gzip_comp_level = level;
+}
+
 std::string		LocationConfig::getPath() const {
 	return (this->path);
 }
@@ -67,6 +93,10 @@ size_t	LocationConfig::getClientMaxBodySize() const {
 	return (this->client_max_body_size);
 }
 
+bool	LocationConfig::hasClientMaxBodySize() const {
+	return (this->has_client_max_body_size);
+}
+
 std::vector<std::string> LocationConfig::getMethods() const {
 	return (this->methods);
 }
@@ -99,3 +129,27 @@ std::string	LocationConfig::getReturnUrl() const {
 std::string	LocationConfig::getUploadStore() const {
 	return upload_store;
 }
+
+bool	LocationConfig::getGzip() const {
+	return (this->gzip);
+}
+
+// contentType may carry parameters ("text/html; charset=utf-8"); only the
+// media type itself is compared.
+bool	LocationConfig::isGzipType(const std::string& contentType) const {
+	std::string mediaType = ParseUtils::trim(contentType.substr(0, contentType.find(';')));
+	for (size_t i = 0; i < gzip_types.size(); ++i) {
+		if (gzip_types[i] == "*" || strcasecmp(gzip_types[i].c_str(), mediaType.c_str()) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t	LocationConfig::getGzipMinLength() const {
+	return (this->gzip_min_length);
+}
+
+int		LocationConfig::getGzipCompLevel() const {
+	return (this->gzip_comp_level);
+}
@@ -11,11 +11,16 @@ class LocationConfig {
 		std::vector<std::string>	methods;
 		bool						cgi_enabled;
 		size_t						client_max_body_size;
+		bool						has_client_max_body_size;
 		bool						autoindex;
 		bool						has_return;
 		int							return_code;
 		std::string					return_url;
 		std::string					upload_store;
+		bool						gzip;
+		std::vector<std::string>	gzip_types;
+		size_t						gzip_min_length;
+		int							gzip_comp_level;
 
 	public:
 		LocationConfig(); 
@@ -28,6 +33,10 @@ class LocationConfig {
 		void		setAutoIndex(bool autoindex);
 		void		setReturn(int code, const std::string& url);
 		void		setUploadStore(const std::string& path);
+		void		setGzip(bool state);
+		void		setGzipTypes(const std::vector<std::string>& types);
+		void		setGzipMinLength(size_t length);
+		void		setGzipCompLevel(int level);
 
 		std::string					getPath() const;
 		std::string					getRoot() const;
@@ -36,9 +45,14 @@ class LocationConfig {
 		bool						isCGIEnabled()	const;
 		bool						isMethodAllowed(const std::string& method) const;
 		size_t						getClientMaxBodySize() const;
+		bool						hasClientMaxBodySize() const;
 		bool						getAutoIndex() const;
 		bool						hasReturn() const;
 		int							getReturnCode() const;
 		std::string					getReturnUrl() const;
 		std::string					getUploadStore() const;
+		bool						getGzip() const;
+		bool						isGzipType(const std::string& contentType) const;
+		size_t						getGzipMinLength() const;
+		int							getGzipCompLevel() const;
 };
\ No newline at end of file
@@ -1,7 +1,11 @@
 
 #include "ServerConfig.hpp"
 
-ServerConfig::ServerConfig() : port(-1), host(""), root(""), client_max_body_size(1024 * 1024), autoindex(false) {}
+ServerConfig::ServerConfig() : port(-1), host(""), root(""), client_max_body_size(1024 * 1024), autoindex(false),
+                               keepalive_timeout(75), keepalive_requests(100),
+                               client_header_timeout(60), client_body_timeout(60),
+                               send_timeout(60), cgi_timeout(30),
+                               client_body_buffer_size(64 * 1024), client_body_temp_path("/tmp") {}
 
 void	ServerConfig::setPort(int portNum) {
 	port = portNum;
@@ -31,6 +35,38 @@ void    ServerConfig::setAutoIndex(bool autoindex) {
     this->autoindex = autoindex;
 }
 
+void    ServerConfig::setKeepAliveTimeout(size_t seconds) {
+    keepalive_timeout = seconds;
+}
+
+void    ServerConfig::setKeepAliveRequests(size_t count) {
+    keepalive_requests = count;
+}
+
+void    ServerConfig::setClientHeaderTimeout(size_t seconds) {
+    client_header_timeout = seconds;
+}
+
+void    ServerConfig::setClientBodyTimeout(size_t seconds) {
+    client_body_timeout = seconds;
+}
+
+void    ServerConfig::setSendTimeout(size_t seconds) {
+    send_timeout = seconds;
+}
+
+void    ServerConfig::setCgiTimeout(size_t seconds) {
+    cgi_timeout = seconds;
+}
+
+void    ServerConfig::setClientBodyBufferSize(size_t size) {
+    client_body_buffer_size = size;
+}
+
+void    ServerConfig::setClientBodyTempPath(const std::string& path) {
+    client_body_temp_path = path;
+}
+
 int		ServerConfig::getPort() const {
 	return (this->port);
 }
@@ -48,11 +84,19 @@ size_t	ServerConfig::getClientMaxBodySize() const {
 	return (this->client_max_body_size);
 }
 
+// A location's own client_max_body_size overrides the server-wide one.
+size_t	ServerConfig::getClientMaxBodySize(const LocationConfig* location) const {
+	if (location && location->hasClientMaxBodySize()) {
+		return (location->getClientMaxBodySize());
+	}
+	return (this->client_max_body_size);
+}
+
 std::map<int, std::string> ServerConfig::getErrorPages() const {
 	return (this->error_pages);
 }
 
-std::vector<LocationConfig> ServerConfig::getLocations() const {
+const std::vector<LocationConfig>&	ServerConfig::getLocations() const {
 	return (this->locations);
 }
 
@@ -60,6 +104,38 @@ bool    ServerConfig::getAutoIndex() const {
     return (this->autoindex);
 }
 
+size_t  ServerConfig::getKeepAliveTimeout() const {
+    return (this->keepalive_timeout);
+}
+
+size_t  ServerConfig::getKeepAliveRequests() const {
+    return (this->keepalive_requests);
+}
+
+size_t  ServerConfig::getClientHeaderTimeout() const {
+    return (this->client_header_timeout);
+}
+
+size_t  ServerConfig::getClientBodyTimeout() const {
+    return (this->client_body_timeout);
+}
+
+size_t  ServerConfig::getSendTimeout() const {
+    return (this->send_timeout);
+}
+
+size_t  ServerConfig::getCgiTimeout() const {
+    return (this->cgi_timeout);
+}
+
+size_t  ServerConfig::getClientBodyBufferSize() const {
+    return (this->client_body_buffer_size);
+}
+
+std::string ServerConfig::getClientBodyTempPath() const {
+    return (this->client_body_temp_path);
+}
+
 const LocationConfig* ServerConfig::findLocation(const std::string& uri) const {
     const LocationConfig* bestMatch = NULL;
     size_t longestMatch = 0;
@@ -12,6 +12,14 @@ class ServerConfig {
 		std::string					root;
 		size_t						client_max_body_size;
 		bool						autoindex;
+		size_t						keepalive_timeout;
+		size_t						keepalive_requests;
+		size_t						client_header_timeout;
+		size_t						client_body_timeout;
+		size_t						send_timeout;
+		size_t						cgi_timeout;
+		size_t						client_body_buffer_size;
+		std::string					client_body_temp_path;
 		std::map<int, std::string>	error_pages;
 		std::vector<LocationConfig>	locations;
 		
@@ -25,14 +33,31 @@ class ServerConfig {
 		void						setLocations(std::vector<LocationConfig> locations);
 		void 						setClientMaxBodySize(size_t size);
 		void						setAutoIndex(bool autoindex);
+		void						setKeepAliveTimeout(size_t seconds);
+		void						setKeepAliveRequests(size_t count);
+		void						setClientHeaderTimeout(size_t seconds);
+		void						setClientBodyTimeout(size_t seconds);
+		void						setSendTimeout(size_t seconds);
+		void						setCgiTimeout(size_t seconds);
+		void						setClientBodyBufferSize(size_t size);
+		void						setClientBodyTempPath(const std::string& path);
 		
 		int							getPort() const;
 		std::string					getRoot() const;
 		std::string					getHost() const;
 		std::map<int, std::string>	getErrorPages() const;
-		std::vector<LocationConfig>	getLocations() const;
+		const std::vector<LocationConfig>&	getLocations() const;
 		size_t						getClientMaxBodySize() const;
+		size_t						getClientMaxBodySize(const LocationConfig* location) const;
 		bool						getAutoIndex() const;
+		size_t						getKeepAliveTimeout() const;
+		size_t						getKeepAliveRequests() const;
+		size_t						getClientHeaderTimeout() const;
+		size_t						getClientBodyTimeout() const;
+		size_t						getSendTimeout() const;
+		size_t						getCgiTimeout() const;
+		size_t						getClientBodyBufferSize() const;
+		std::string					getClientBodyTempPath() const;
 		const LocationConfig* findLocation(const std::string& uri) const;
 
 };
\ No newline at end of file
@@ -9,12 +9,14 @@
 #include <sstream>
 #include <iostream>
 #include <cstring>
+#include <strings.h>
 #include <cerrno>
 #include <sys/stat.h>
 #include "../../../../include/GlobalUtils.hpp"
+#include "../utils/ContentEncoding.hpp"
 
 std::map<int, CgiExecution*> CGIhandler::s_cgiExecutions;
-const int CGIhandler::CGI_TIMEOUT_SECONDS;
+std::vector<CgiExecution*> CGIhandler::s_retiredExecutions;
 
 static std::string stripQueryString(const std::string &uri) {
     std::string::size_type pos = uri.find('?');
@@ -39,6 +41,28 @@ CGIhandler::CGIhandler() {
 CGIhandler::~CGIhandler() {
 }
 
+// Both routing the request body and dispatching the request ask this, so a
+// script is never treated as an upload target by one and run by the other.
+bool CGIhandler::isCgiByExtension(const std::string& uri) {
+    std::string uriPath = uri;
+    size_t queryPos = uriPath.find('?');
+    if (queryPos != std::string::npos) {
+        uriPath = uriPath.substr(0, queryPos);
+    }
+    
+    const char* extensions[] = {".php", ".py", ".js", ".rb", ".pl", ".cgi", ".sh", NULL};
+    
+    for (int i = 0; extensions[i] != NULL; ++i) {
+        std::string ext = extensions[i];
+        if (uriPath.length() >= ext.length()) {
+            if (uriPath.substr(uriPath.length() - ext.length()) == ext) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
 Response* CGIhandler::handler(const Request &req, const LocationConfig* location, const ServerConfig* serverConfig) {
     
     (void)req;
@@ -50,7 +74,7 @@ Response* CGIhandler::handler(const Request &req, const LocationConfig* location
     res->setBody("<html><body><h1>500 Internal Server Error</h1></body></html>");
     res->addHeader("Content-Type", "text/html");
     std::ostringstream oss;
-    oss << res->getBody().size();
+    oss << res->getContentSize();
     res->addHeader("Content-Length", oss.str());
     return res;
 }
@@ -92,7 +116,7 @@ bool CGIhandler::startCgiExecution(const Request &req,
         oss << body.size();
         res->addHeader("Content-Length", oss.str());
         
-        client->setCgiResponse(res);
+        client->setResponse(res);
         return false;
     }
     
@@ -113,7 +137,7 @@ bool CGIhandler::startCgiExecution(const Request &req,
         oss << body.size();
         res->addHeader("Content-Length", oss.str());
         
-        client->setCgiResponse(res);
+        client->setResponse(res);
         return false;
     }
     
@@ -132,10 +156,10 @@ bool CGIhandler::startCgiExecution(const Request &req,
         res->setBody("<html><body><h1>500 Internal Server Error</h1></body></html>");
         res->addHeader("Content-Type", "text/html");
         std::ostringstream oss;
-        oss << res->getBody().size();
+        oss << res->getContentSize();
         res->addHeader("Content-Length", oss.str());
         
-        client->setCgiResponse(res);
+        client->setResponse(res);
         return false;
     }
     
@@ -154,10 +178,10 @@ bool CGIhandler::startCgiExecution(const Request &req,
         res->setBody("<html><body><h1>500 Internal Server Error</h1></body></html>");
         res->addHeader("Content-Type", "text/html");
         std::ostringstream oss;
-        oss << res->getBody().size();
+        oss << res->getContentSize();
         res->addHeader("Content-Length", oss.str());
         
-        client->setCgiResponse(res);
+        client->setResponse(res);
         return false;
     }
     
@@ -175,10 +199,14 @@ bool CGIhandler::startCgiExecution(const Request &req,
     exec->client = client;
     exec->serverConfig = serverConfig;
     exec->scriptPath = scriptPath;
-    exec->requestBody = std::string(req.getRawBinaryBody().begin(), req.getRawBinaryBody().end());
+    // The body is read from the request's sink as the script consumes it;
+    // the Request outlives the execution, which is aborted if the client goes.
+    exec->requestBody = &req.getBodySink();
     exec->bodyBytesWritten = 0;
-    exec->startTime = time(NULL);
     exec->state = CGI_WRITING_BODY;
+    exec->chunkedAllowed = req.getVersion() == "HTTP/1.1";
+    exec->location = location;
+    exec->acceptedCodings = ContentEncoding::accepted(req.getHeader("Accept-Encoding"));
     
     s_cgiExecutions[socketPair[0]] = exec;
 
@@ -192,7 +220,10 @@ bool CGIhandler::startCgiExecution(const Request &req,
         return false;
     }
     
-    client->setWaitingForCgi(true);
+    if (serverConfig->getCgiTimeout() > 0) {
+        eventMgr.getTimers().schedule(exec, TimerWheel::now() + static_cast<long>(serverConfig->getCgiTimeout()) * 1000L);
+    }
+    client->setCgiExecution(exec);
     
     
     return true;
@@ -209,7 +240,7 @@ bool CGIhandler::forkAndExecCgi(const std::string &scriptPath,
     }
     
     if (pid == 0) {
-        
+        signal(SIGPIPE, SIG_DFL);
         close(socketPair[0]);
         
         if (dup2(socketPair[1], STDIN_FILENO) == -1 || dup2(socketPair[1], STDOUT_FILENO) == -1 ){
@@ -245,15 +276,11 @@ bool CGIhandler::forkAndExecCgi(const std::string &scriptPath,
     return true;
 }
 
-void CGIhandler::handleCgiEvent(int fd, uint32_t events, EventManager& eventMgr) {
-    std::map<int, CgiExecution*>::iterator it = s_cgiExecutions.find(fd);
-    if (it == s_cgiExecutions.end()) {
+void CGIhandler::handleCgiEvent(CgiExecution* exec, uint32_t events, EventManager& eventMgr) {
+    if (exec->socketFd < 0) {
         return;
     }
     
-    CgiExecution* exec = it->second;
-    
-    
     if (events & EPOLLERR) {
         exec->state = CGI_ERROR;
         finalizeCgiExecution(exec, eventMgr);
@@ -263,10 +290,7 @@ void CGIhandler::handleCgiEvent(int fd, uint32_t events, EventManager& eventMgr)
     if (events & EPOLLHUP) {
         if (exec->state == CGI_READING_OUTPUT) {
             handleCgiRead(exec, eventMgr);
-            
-            if (s_cgiExecutions.find(fd) == s_cgiExecutions.end()) {
-                return;
-            }
+            return;
         }
         exec->state = CGI_COMPLETE;
         finalizeCgiExecution(exec, eventMgr);
@@ -281,7 +305,8 @@ void CGIhandler::handleCgiEvent(int fd, uint32_t events, EventManager& eventMgr)
 }
 
 void CGIhandler::handleCgiWrite(CgiExecution* exec, EventManager& eventMgr) {
-    if (exec->requestBody.empty() || exec->bodyBytesWritten >= exec->requestBody.size()) {
+    size_t bodySize = exec->requestBody ? exec->requestBody->size() : 0;
+    if (exec->bodyBytesWritten >= bodySize) {
         
         shutdown(exec->socketFd, SHUT_WR);
         
@@ -290,33 +315,240 @@ void CGIhandler::handleCgiWrite(CgiExecution* exec, EventManager& eventMgr) {
         return;
     }
     
-    size_t remaining = exec->requestBody.size() - exec->bodyBytesWritten;
-    ssize_t written = write(exec->socketFd, 
-                           exec->requestBody.c_str() + exec->bodyBytesWritten,
-                           remaining);
+    char buffer[32768];
+    size_t budget = eventMgr.getIoBudget();
+    size_t sent = 0;
     
-    if (written > 0) {
+    while (exec->bodyBytesWritten < bodySize) {
+        if (sent >= budget) {
+            if (eventMgr.isEdgeTriggered()) {
+                eventMgr.modifySocket(exec->socketFd, exec, EPOLLOUT | EPOLLERR | EPOLLHUP);
+            }
+            return;
+        }
+        
+        size_t remaining;
+        try {
+            remaining = exec->requestBody->readAt(exec->bodyBytesWritten, buffer, sizeof(buffer));
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] CGI stdin: " << e.what() << std::endl;
+            exec->state = CGI_ERROR;
+            finalizeCgiExecution(exec, eventMgr);
+            return;
+        }
+        ssize_t written = send(exec->socketFd, buffer, remaining, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                exec->state = CGI_ERROR;
+                finalizeCgiExecution(exec, eventMgr);
+            }
+            return;
+        }
+        
         exec->bodyBytesWritten += written;
+        sent += written;
+        if (static_cast<size_t>(written) < remaining) {
+            return;
+        }
+    }
+    
+    shutdown(exec->socketFd, SHUT_WR);
+    exec->state = CGI_READING_OUTPUT;
+    eventMgr.modifySocket(exec->socketFd, exec, EPOLLIN | EPOLLERR | EPOLLHUP);
+}
+
+// Output is forwarded as it is read. While the client has more than
+// CGI_OUTPUT_HIGH_WATER bytes unsent, the script's socket is taken out of
+// epoll, so a slow client throttles the script instead of growing our buffer.
+bool CGIhandler::handleCgiRead(CgiExecution* exec, EventManager& eventMgr) {
+    char buffer[32768];
+    size_t budget = eventMgr.getIoBudget();
+    size_t consumed = 0;
+    
+    while (consumed < budget) {
+        if (exec->streaming && exec->client->getPendingOutput() >= CGI_OUTPUT_HIGH_WATER) {
+            // While paused the script waits on the client, which send_timeout
+            // already covers.
+            if (!exec->paused) {
+                eventMgr.removeSocket(exec->socketFd);
+                eventMgr.getTimers().cancel(exec);
+                exec->paused = true;
+            }
+            return false;
+        }
+        
+        ssize_t bytes = read(exec->socketFd, buffer, sizeof(buffer));
         
-        if (exec->bodyBytesWritten >= exec->requestBody.size()) {
-            shutdown(exec->socketFd, SHUT_WR);
-            exec->state = CGI_READING_OUTPUT;
-            eventMgr.modifySocket(exec->socketFd, exec, EPOLLIN | EPOLLERR | EPOLLHUP);
+        if (bytes > 0) {
+            consumed += bytes;
+            if (!forwardCgiOutput(exec, buffer, static_cast<size_t>(bytes))) {
+                std::cerr << "[ERROR] CGI script " << exec->scriptPath << " sent no header block" << std::endl;
+                exec->state = CGI_ERROR;
+                finalizeCgiExecution(exec, eventMgr);
+                return true;
+            }
+            continue;
+        }
+        if (bytes == 0) {
+            exec->state = CGI_COMPLETE;
+            finalizeCgiExecution(exec, eventMgr);
+            return true;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            exec->state = CGI_ERROR;
+            finalizeCgiExecution(exec, eventMgr);
+            return true;
         }
-    } else if (written < 0) {
+        break;
+    }
+    
+    // The timeout limits silence from the script, not the length of a
+    // response it is still producing.
+    if (consumed > 0 && exec->serverConfig->getCgiTimeout() > 0) {
+        eventMgr.getTimers().schedule(exec, TimerWheel::now() + static_cast<long>(exec->serverConfig->getCgiTimeout()) * 1000L);
+    }
+    if (consumed >= budget && !exec->paused && eventMgr.isEdgeTriggered()) {
+        eventMgr.modifySocket(exec->socketFd, exec, EPOLLIN | EPOLLERR | EPOLLHUP);
     }
+    return false;
 }
 
-void CGIhandler::handleCgiRead(CgiExecution* exec, EventManager& eventMgr) {
-    char buffer[8192];
-    ssize_t bytes = read(exec->socketFd, buffer, sizeof(buffer));
+void CGIhandler::resumeCgiOutput(CgiExecution* exec, EventManager& eventMgr) {
+    if (!exec->paused || exec->socketFd < 0) {
+        return;
+    }
+    exec->paused = false;
+    eventMgr.addSocket(exec->socketFd, exec, EPOLLIN | EPOLLERR | EPOLLHUP);
+    if (exec->serverConfig->getCgiTimeout() > 0) {
+        eventMgr.getTimers().schedule(exec, TimerWheel::now() + static_cast<long>(exec->serverConfig->getCgiTimeout()) * 1000L);
+    }
+}
+
+static size_t findCgiHeaderEnd(const std::string& output, size_t& bodyStart) {
+    size_t headerEnd = output.find("\r\n\r\n");
+    size_t lfEnd = output.find("\n\n");
     
-    if (bytes > 0) {
-        exec->output.append(buffer, bytes);
-    } else if (bytes == 0) {
-        exec->state = CGI_COMPLETE;
-        finalizeCgiExecution(exec, eventMgr);
+    if (lfEnd != std::string::npos && (headerEnd == std::string::npos || lfEnd < headerEnd)) {
+        bodyStart = lfEnd + 2;
+        return lfEnd;
+    }
+    if (headerEnd != std::string::npos) {
+        bodyStart = headerEnd + 4;
+    }
+    return headerEnd;
+}
+
+// Output is held only until the script's header block is complete; from
+// then on it goes straight to the client.
+bool CGIhandler::forwardCgiOutput(CgiExecution* exec, const char* data, size_t size) {
+    if (exec->streaming) {
+        forwardCgiBody(exec, data, size);
+        return true;
+    }
+    
+    exec->output.append(data, size);
+    size_t bodyStart = 0;
+    size_t headerEnd = findCgiHeaderEnd(exec->output, bodyStart);
+    if (headerEnd == std::string::npos) {
+        return exec->output.size() <= MAX_CGI_HEADER_SIZE;
+    }
+    startCgiStream(exec, headerEnd, bodyStart);
+    return true;
+}
+
+static bool findHeaderIgnoreCase(const std::map<std::string, std::string>& headers,
+                                 const char* name, std::string& value) {
+    for (std::map<std::string, std::string>::const_iterator it = headers.begin(); it != headers.end(); ++it) {
+        if (strcasecmp(it->first.c_str(), name) == 0) {
+            value = it->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CGIhandler::startCgiStream(CgiExecution* exec, size_t headerEnd, size_t bodyStart) {
+    Response* head = new Response();
+    head->setVersion("HTTP/1.0");
+    CGIhandler tempHandler;
+    tempHandler.parseCgiHeaders(exec->output.substr(0, headerEnd), head);
+    
+    std::string contentLength;
+    bool hasLength = findHeaderIgnoreCase(head->getHeaders(), "Content-Length", contentLength)
+        && !contentLength.empty() && contentLength.find_first_not_of("0123456789") == std::string::npos;
+    if (hasLength) {
+        exec->lengthLimited = true;
+        exec->bodyRemaining = static_cast<size_t>(std::strtoul(contentLength.c_str(), NULL, 10));
+    }
+    
+    // The script's Content-Length still bounds what is read from it, but the
+    // compressed length is only known at the end, so the output is framed
+    // as if none had been given.
+    int level = GzipEncoder::negotiate(exec->acceptedCodings, exec->location, *head,
+                                       hasLength ? exec->bodyRemaining : std::numeric_limits<size_t>::max());
+    if (level > 0) {
+        exec->gzip = new GzipEncoder();
+        if (exec->gzip->begin(level)) {
+            head->removeHeader("Content-Length");
+            head->addHeader("Content-Encoding", "gzip");
+            hasLength = false;
+        } else {
+            delete exec->gzip;
+            exec->gzip = NULL;
+        }
+    }
+    
+    if (hasLength) {
+        exec->framing = CGI_OUTPUT_LENGTH;
+    } else if (exec->chunkedAllowed) {
+        exec->framing = CGI_OUTPUT_CHUNKED;
+        head->addHeader("Transfer-Encoding", "chunked");
+    } else {
+        exec->framing = CGI_OUTPUT_CLOSE;
+    }
+    
+    std::string body = exec->output.substr(bodyStart);
+    std::string().swap(exec->output);
+    exec->streaming = true;
+    exec->client->beginStreamedResponse(head, exec->framing == CGI_OUTPUT_CLOSE);
+    forwardCgiBody(exec, body.data(), body.size());
+}
+
+void CGIhandler::forwardCgiBody(CgiExecution* exec, const char* data, size_t size) {
+    if (exec->lengthLimited) {
+        size = std::min(size, exec->bodyRemaining);
+        exec->bodyRemaining -= size;
+    }
+    if (size == 0) {
+        return;
+    }
+    if (exec->gzip) {
+        std::string compressed;
+        exec->gzip->write(data, size, compressed, false);
+        sendCgiBody(exec, compressed.data(), compressed.size());
+    } else {
+        sendCgiBody(exec, data, size);
+    }
+}
+
+void CGIhandler::sendCgiBody(CgiExecution* exec, const char* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    if (exec->framing == CGI_OUTPUT_CHUNKED) {
+        char sizeLine[32];
+        int length = snprintf(sizeLine, sizeof(sizeLine), "%lx\r\n", static_cast<unsigned long>(size));
+        exec->client->appendResponseData(sizeLine, static_cast<size_t>(length));
+        exec->client->appendResponseData(data, size);
+        exec->client->appendResponseData("\r\n", 2);
     } else {
+        exec->client->appendResponseData(data, size);
     }
 }
 
@@ -348,6 +580,24 @@ void CGIhandler::finalizeCgiExecution(CgiExecution* exec, EventManager& eventMgr
         exec->scriptExitCode = -1;
     }
     
+    Client* client = exec->client;
+    
+    if (exec->streaming) {
+        bool complete = exec->state == CGI_COMPLETE && exec->scriptExitCode == 0
+                        && (!exec->lengthLimited || exec->bodyRemaining == 0);
+        if (complete && exec->gzip) {
+            std::string trailer;
+            exec->gzip->write(NULL, 0, trailer, true);
+            sendCgiBody(exec, trailer.data(), trailer.size());
+        }
+        if (complete && exec->framing == CGI_OUTPUT_CHUNKED) {
+            client->appendResponseData("0\r\n\r\n", 5);
+        }
+        cleanupCgiExecution(exec->socketFd, eventMgr);
+        client->endStreamedResponse(complete);
+        return;
+    }
+    
     Response* response = NULL;
     
     if (exec->state == CGI_TIMEOUT) {
@@ -365,16 +615,13 @@ void CGIhandler::finalizeCgiExecution(CgiExecution* exec, EventManager& eventMgr
         std::map<std::string, std::string> headers = response->getHeaders();
         if (headers.find("Content-Length") == headers.end()) {
             std::ostringstream oss;
-            oss << response->getBody().size();
+            oss << response->getContentSize();
             response->addHeader("Content-Length", oss.str());
         }
-        response->setConnection("close");
     }
     
-    exec->client->setCgiResponse(response);
-    exec->client->setWaitingForCgi(false);
-    
     cleanupCgiExecution(exec->socketFd, eventMgr);
+    client->setCgiResponse(response);
 }
 
 void CGIhandler::cleanupCgiExecution(int fd, EventManager& eventMgr) {
@@ -385,39 +632,53 @@ void CGIhandler::cleanupCgiExecution(int fd, EventManager& eventMgr) {
     
     CgiExecution* exec = it->second;
     
-    
-    eventMgr.removeSocket(fd);
+    eventMgr.getTimers().cancel(exec);
+    if (!exec->paused) {
+        eventMgr.removeSocket(fd);
+    }
     
     if (exec->socketFd > 0) {
         close(exec->socketFd);
     }
+    exec->socketFd = -1;
+    exec->client = NULL;
     
     s_cgiExecutions.erase(it);
     
-    delete exec;
+    s_retiredExecutions.push_back(exec);
+}
+
+void CGIhandler::releaseRetiredExecutions() {
+    for (size_t i = 0; i < s_retiredExecutions.size(); ++i) {
+        delete s_retiredExecutions[i];
+    }
+    s_retiredExecutions.clear();
+}
+
+void CGIhandler::abortCgiExecution(CgiExecution* exec, EventManager& eventMgr) {
+    if (exec->socketFd < 0) {
+        return;
+    }
+    
+    if (exec->pid > 0) {
+        int status;
+        kill(exec->pid, SIGKILL);
+        waitpid(exec->pid, &status, 0);
+    }
+    cleanupCgiExecution(exec->socketFd, eventMgr);
 }
 
-void CGIhandler::checkCgiTimeouts(EventManager& eventMgr) {
-    time_t now = time(NULL);
+void CGIhandler::handleCgiTimeout(CgiExecution* exec, EventManager& eventMgr) {
+    if (exec->socketFd < 0) {
+        return;
+    }
     
-    std::map<int, CgiExecution*>::iterator it = s_cgiExecutions.begin();
-    while (it != s_cgiExecutions.end()) {
-        CgiExecution* exec = it->second;
-        
-        if (now - exec->startTime > CGI_TIMEOUT_SECONDS) {
-            exec->state = CGI_TIMEOUT;
-            
-            if (exec->pid > 0) {
-                kill(exec->pid, SIGKILL);
-            }
-            
-            finalizeCgiExecution(exec, eventMgr);
-            
-            it = s_cgiExecutions.begin();
-        } else {
-            ++it;
-        }
+    std::cout << "[TIMEOUT] CGI script " << exec->scriptPath << " exceeded its time limit" << std::endl;
+    exec->state = CGI_TIMEOUT;
+    if (exec->pid > 0) {
+        kill(exec->pid, SIGKILL);
     }
+    finalizeCgiExecution(exec, eventMgr);
 }
 
 std::vector<char*> CGIhandler::buildEnv(const Request &req, const LocationConfig* location, const ServerConfig* serverConfig) {
@@ -468,7 +729,7 @@ std::vector<char*> CGIhandler::buildEnv(const Request &req, const LocationConfig
     envMap["REQUEST_URI"] = uri;
     
     std::ostringstream ssContentLen;
-    ssContentLen << req.getRawBinaryBody().size();
+    ssContentLen << req.getBodySize();
     envMap["CONTENT_LENGTH"] = ssContentLen.str();
     
     envMap["GATEWAY_INTERFACE"] = "CGI/1.1";
@@ -482,24 +743,23 @@ std::vector<char*> CGIhandler::buildEnv(const Request &req, const LocationConfig
     
     envMap["SERVER_SOFTWARE"] = "WebServer/1.0";
     
-    std::map<std::string, std::string> headers = req.getHeaders();
-    for (std::map<std::string, std::string>::const_iterator it = headers.begin();
-         it != headers.end(); ++it) {
+    for (size_t h = 0; h < req.getHeaderCount(); ++h) {
+        BufferView name = req.getHeaderName(h);
         
-        if (it->first == "Content-Type") {
-            envMap["CONTENT_TYPE"] = it->second;
+        if (name.equalsIgnoreCase("Content-Type")) {
+            envMap["CONTENT_TYPE"] = req.getHeaderValue(h);
             continue;
         }
-        if (it->first == "Content-Length") continue;
+        if (name.equalsIgnoreCase("Content-Length") || name.equalsIgnoreCase("Transfer-Encoding")) continue;
         
         std::string httpKey = "HTTP_";
-        for (size_t i = 0; i < it->first.length(); ++i) {
-            char c = it->first[i];
+        for (size_t i = 0; i < name.size(); ++i) {
+            char c = name[i];
             if (c == '-') httpKey += '_';
             else if (c >= 'a' && c <= 'z') httpKey += (char)(c - 'a' + 'A');
             else httpKey += c;
         }
-        envMap[httpKey] = it->second;
+        envMap[httpKey] = req.getHeaderValue(h);
     }
     
     std::vector<char*> env;
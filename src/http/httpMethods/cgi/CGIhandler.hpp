@@ -4,7 +4,9 @@
 #include "../HttpMethodHandler.hpp"
 #include "../../../config/LocationConfig.hpp"
 #include "../../response/Response.hpp"
+#include "../../response/GzipEncoder.hpp"
 #include "../../../server/Server.hpp"
+#include "../../../server/EventSource.hpp"
 
 class Client;
 
@@ -16,22 +18,44 @@ enum CgiState {
     CGI_TIMEOUT
 };
 
-struct CgiExecution {
+// How the body of a streamed CGI response is delimited for the client.
+enum CgiOutputFraming {
+    CGI_OUTPUT_LENGTH,
+    CGI_OUTPUT_CHUNKED,
+    CGI_OUTPUT_CLOSE
+};
+
+struct CgiExecution : public EventSource {
     pid_t pid;
     int socketFd;
     Client* client;
     const ServerConfig* serverConfig;
     std::string scriptPath;
-    std::string requestBody;
+    const BodySink* requestBody;
     size_t bodyBytesWritten;
     std::string output;
-    time_t startTime;
     CgiState state;
     int scriptExitCode;
+    bool chunkedAllowed;
+    bool streaming;
+    bool paused;
+    CgiOutputFraming framing;
+    bool lengthLimited;
+    size_t bodyRemaining;
+    const LocationConfig* location;
+    unsigned acceptedCodings;
+    GzipEncoder* gzip;
     
-    CgiExecution() : pid(-1), socketFd(-1), client(NULL), serverConfig(NULL),
-                     bodyBytesWritten(0), startTime(0),
-                     state(CGI_WRITING_BODY), scriptExitCode(0) {}
+    CgiExecution() : EventSource(EVENT_CGI), pid(-1), socketFd(-1), client(NULL), serverConfig(NULL),
+                     requestBody(NULL), bodyBytesWritten(0),
+                     state(CGI_WRITING_BODY), scriptExitCode(0), chunkedAllowed(false),
+                     streaming(false), paused(false), framing(CGI_OUTPUT_CLOSE), lengthLimited(false),
+                     bodyRemaining(0), location(NULL), acceptedCodings(0), gzip(NULL) {}
+    ~CgiExecution() { delete gzip; }
+
+private:
+    CgiExecution(const CgiExecution&);
+    CgiExecution& operator=(const CgiExecution&);
 };
 
 class CGIhandler : public HttpMethodHandler {
@@ -40,18 +64,26 @@ public:
     virtual ~CGIhandler();
     virtual Response* handler(const Request &req, const LocationConfig* location, const ServerConfig* serverConfig);
     
+    static bool isCgiByExtension(const std::string& uri);
     static bool startCgiExecution(const Request &req, 
                                   const LocationConfig* location,
                                   const ServerConfig* serverConfig,
                                   Client* client,
                                   class EventManager& eventMgr);
     
-    static void handleCgiEvent(int fd, uint32_t events, class EventManager& eventMgr);
+    static void handleCgiEvent(CgiExecution* exec, uint32_t events, class EventManager& eventMgr);
     static void cleanupCgiExecution(int fd, class EventManager& eventMgr);
-    static void checkCgiTimeouts(class EventManager& eventMgr);
+    static void handleCgiTimeout(CgiExecution* exec, class EventManager& eventMgr);
+    static void abortCgiExecution(CgiExecution* exec, class EventManager& eventMgr);
+    static void resumeCgiOutput(CgiExecution* exec, class EventManager& eventMgr);
+    static void releaseRetiredExecutions();
     static std::map<int, CgiExecution*> s_cgiExecutions;
+    static std::vector<CgiExecution*> s_retiredExecutions;
 
 private:
+    static const size_t MAX_CGI_HEADER_SIZE = 64 * 1024;
+    static const size_t CGI_OUTPUT_HIGH_WATER = 256 * 1024;
+
     std::vector<char*> buildEnv(const Request &req, const LocationConfig* location, const ServerConfig* serverConfig);
     Response* parseCgiOutput(const std::string &output, int exitCode);
     void parseCgiHeaders(const std::string &headersStr, Response *res);
@@ -62,10 +94,10 @@ private:
                               pid_t& outPid);
     
     static void handleCgiWrite(CgiExecution* exec, class EventManager& eventMgr);
-    static void handleCgiRead(CgiExecution* exec, class EventManager& eventMgr);
+    static bool handleCgiRead(CgiExecution* exec, class EventManager& eventMgr);
     static void finalizeCgiExecution(CgiExecution* exec, class EventManager& eventMgr);
-    
-
-    
-    static const int CGI_TIMEOUT_SECONDS = 30;
+    static bool forwardCgiOutput(CgiExecution* exec, const char* data, size_t size);
+    static void startCgiStream(CgiExecution* exec, size_t headerEnd, size_t bodyStart);
+    static void forwardCgiBody(CgiExecution* exec, const char* data, size_t size);
+    static void sendCgiBody(CgiExecution* exec, const char* data, size_t size);
 };
\ No newline at end of file
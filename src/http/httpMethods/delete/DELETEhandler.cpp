@@ -1,5 +1,6 @@
 #include "./DELETEhandler.hpp"
 #include "../../../../include/webserv.hpp"
+#include "../utils/FileCache.hpp"
 
 static bool fileExists(const std::string &path) {
     struct stat buffer;
@@ -23,6 +24,7 @@ Response* DELETEhandler::handler(const Request &req, const LocationConfig* locat
     if (unlink(filePath.c_str()) != 0) {
         return Response::makeErrorResponse(500);
     }
+    FileCache::invalidate(filePath);
     
     Response* response = new Response();
     response->setStatus(204);
@@ -0,0 +1,499 @@
+#include "DirectoryListing.hpp"
+#include "../../../../include/GlobalUtils.hpp"
+#include <sys/inotify.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <sstream>
+#include <iomanip>
+#include <set>
+#include <algorithm>
+#include <iterator>
+
+const uint32_t DirectoryListing::WATCH_MASK = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+    | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+std::map<std::string, DirectoryListing::Listing> DirectoryListing::s_listings;
+std::list<std::string> DirectoryListing::s_lru;
+std::map<int, std::string> DirectoryListing::s_watches;
+int DirectoryListing::s_inotifyFd = -1;
+size_t DirectoryListing::s_bytes = 0;
+size_t DirectoryListing::s_maxBytes = 0;
+
+static const char* const HTML_HEAD_START =
+    "<!DOCTYPE html>\n"
+    "<html lang=\"en\">\n"
+    "<head>\n"
+    "    <meta charset=\"UTF-8\">\n"
+    "    <meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">\n"
+    "    <title>Index of ";
+
+static const char* const HTML_HEAD_STYLE =
+    "</title>\n"
+    "    <style>\n"
+    "        * { margin: 0; padding: 0; box-sizing: border-box; }\n"
+    "        body { font-family: 'Segoe UI', Arial, sans-serif; background: #f5f5f5; padding: 20px; }\n"
+    "        .container { max-width: 1000px; margin: 0 auto; background: white; border-radius: 8px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); }\n"
+    "        .header { background: linear-gradient(135deg, #667eea 0%, #764ba2 100%); color: white; padding: 30px; border-radius: 8px 8px 0 0; }\n"
+    "        h1 { font-size: 1.8em; margin-bottom: 5px; }\n"
+    "        .path { opacity: 0.9; font-size: 0.9em; }\n"
+    "        table { width: 100%; border-collapse: collapse; }\n"
+    "        th { background: #f8f9fa; padding: 15px; text-align: left; font-weight: 600; color: #333; border-bottom: 2px solid #dee2e6; }\n"
+    "        td { padding: 12px 15px; border-bottom: 1px solid #e9ecef; }\n"
+    "        tr:hover { background: #f8f9fa; }\n"
+    "        a { color: #667eea; text-decoration: none; font-weight: 500; }\n"
+    "        a:hover { text-decoration: underline; }\n"
+    "        .icon { display: inline-block; width: 20px; margin-right: 8px; }\n"
+    "        .dir { color: #ffc107; }\n"
+    "        .file { color: #667eea; }\n"
+    "        .size { color: #666; font-size: 0.9em; }\n"
+    "        .footer { padding: 20px; text-align: center; color: #999; font-size: 0.9em; border-top: 1px solid #e9ecef; }\n"
+    "    </style>\n"
+    "</head>\n"
+    "<body>\n"
+    "    <div class=\"container\">\n"
+    "        <div class=\"header\">\n"
+    "            <h1>📁 Index of ";
+
+static const char* const HTML_TABLE_START =
+    "</div>\n"
+    "        </div>\n"
+    "        <table>\n"
+    "            <thead>\n"
+    "                <tr>\n"
+    "                    <th>Name</th>\n"
+    "                    <th>Size</th>\n"
+    "                </tr>\n"
+    "            </thead>\n"
+    "            <tbody>\n";
+
+static const char* const HTML_PARENT_ROW =
+    "                <tr>\n"
+    "                    <td><span class=\"icon dir\">📁</span><a href=\"../\">Parent Directory</a></td>\n"
+    "                    <td class=\"size\">-</td>\n"
+    "                </tr>\n";
+
+static const char* const HTML_TAIL =
+    "            </tbody>\n"
+    "        </table>\n"
+    "        <div class=\"footer\">\n"
+    "            WebServer/1.0\n"
+    "        </div>\n"
+    "    </div>\n"
+    "</body>\n"
+    "</html>\n";
+
+static std::string urlEncode(const std::string &value) {
+    std::ostringstream escaped;
+    escaped.fill('0');
+    escaped << std::hex;
+
+    for (size_t i = 0; i < value.size(); ++i) {
+        char c = value[i];
+        if (isalnum((unsigned char)c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            escaped << c;
+        } else if (c == ' ') {
+            escaped << "%20";
+        } else {
+            escaped << '%' << std::uppercase << std::setw(2) << int((unsigned char)c);
+            escaped << std::nouppercase;
+        }
+    }
+    return escaped.str();
+}
+
+static std::string jsonEscape(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size() + 2);
+    for (size_t i = 0; i < value.size(); ++i) {
+        unsigned char c = value[i];
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static bool sameTime(const struct timespec& a, const struct timespec& b) {
+    return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+}
+
+std::string DirectoryListing::formatFileSize(off_t bytes) {
+    std::ostringstream oss;
+
+    if (bytes < 1024) {
+        oss << bytes << " B";
+    } else if (bytes < 1024 * 1024) {
+        oss << (bytes / 1024.0) << " KB";
+    } else if (bytes < 1024 * 1024 * 1024) {
+        oss << (bytes / (1024.0 * 1024.0)) << " MB";
+    } else {
+        oss << (bytes / (1024.0 * 1024.0 * 1024.0)) << " GB";
+    }
+
+    return oss.str();
+}
+
+void DirectoryListing::configure(size_t maxBytes) {
+    s_maxBytes = maxBytes;
+    trim();
+}
+
+void DirectoryListing::renderRow(const std::string& uri, Row& row) {
+    const DirectoryEntry& e = row.entry;
+    std::string href = uri;
+    if (href.empty() || href[href.length() - 1] != '/') {
+        href += "/";
+    }
+    href += urlEncode(e.name);
+    if (e.isDir) href += "/";
+
+    row.html = "                <tr>\n                    <td>";
+    if (e.isDir) {
+        row.html += "<span class=\"icon dir\">📁</span><a href=\"" + href + "\">" + e.name + "/</a>";
+    } else {
+        row.html += "<span class=\"icon file\">📄</span><a href=\"" + href + "\">" + e.name + "</a>";
+    }
+    row.html += "</td>\n                    <td class=\"size\">";
+    row.html += e.isDir ? std::string("-") : formatFileSize(e.size);
+    row.html += "</td>\n                </tr>\n";
+
+    row.json = "{\"name\":\"" + jsonEscape(e.name) + "\",\"type\":\"" + (e.isDir ? "dir" : "file")
+        + "\",\"size\":" + numberToString(e.isDir ? 0 : static_cast<size_t>(e.size))
+        + ",\"mtime\":" + numberToString(static_cast<size_t>(e.mtime)) + "}";
+}
+
+// Rows are keyed so that the map order is the listing order: directories
+// first, then by name.
+void DirectoryListing::setRow(Listing& listing, const std::string& dirPath, const std::string& name) {
+    if (name.empty() || name[0] == '.') {
+        return;
+    }
+    for (char kind = '0'; kind <= '1'; ++kind) {
+        std::map<std::string, Row>::iterator it = listing.rows.find(kind + name);
+        if (it != listing.rows.end()) {
+            listing.rowBytes -= it->first.size() + it->second.html.size() + it->second.json.size();
+            listing.rows.erase(it);
+        }
+    }
+    listing.page[LISTING_HTML] = SharedBuffer();
+    listing.page[LISTING_JSON] = SharedBuffer();
+
+    Row row;
+    row.entry.name = name;
+    struct stat statbuf;
+    if (stat((dirPath + name).c_str(), &statbuf) == 0) {
+        row.entry.isDir = S_ISDIR(statbuf.st_mode);
+        row.entry.size = statbuf.st_size;
+        row.entry.mtime = statbuf.st_mtime;
+    } else if (errno == ENOENT) {
+        return;
+    } else {
+        row.entry.isDir = false;
+        row.entry.size = 0;
+        row.entry.mtime = 0;
+    }
+    renderRow(listing.uri, row);
+
+    std::string key = (row.entry.isDir ? '0' : '1') + name;
+    listing.rowBytes += key.size() + row.html.size() + row.json.size();
+    listing.rows[key] = row;
+}
+
+// The directory is stat()ed before it is read, so a change made while it is
+// being read shows up as a changed mtime on the next check.
+bool DirectoryListing::readDirectory(const std::string& dirPath, Listing& listing) {
+    struct stat st;
+    if (stat(dirPath.c_str(), &st) != 0) {
+        return false;
+    }
+    DIR* dir = opendir(dirPath.c_str());
+    if (!dir) {
+        return false;
+    }
+    listing.device = st.st_dev;
+    listing.inode = st.st_ino;
+    listing.mtime = st.st_mtim;
+    listing.ctime = st.st_ctim;
+    listing.rows.clear();
+    listing.rowBytes = 0;
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        setRow(listing, dirPath, entry->d_name);
+    }
+    closedir(dir);
+    return true;
+}
+
+// Directories stay ahead of files in every order; within each group size
+// and mtime sort ascending, and ties (and directories by size) go by name.
+bool DirectoryListing::sortKeyLess(const SortKey& a, const SortKey& b) {
+    if (a.isDir != b.isDir) {
+        return a.isDir;
+    }
+    if (a.value != b.value) {
+        return a.value < b.value;
+    }
+    return a.row->entry.name < b.row->entry.name;
+}
+
+void DirectoryListing::selectRows(const Listing& listing, const ListingQuery& query,
+                                  std::vector<const Row*>& rows) {
+    size_t total = listing.rows.size();
+    size_t first = std::min(query.offset, total);
+    size_t count = std::min(query.limit, total - first);
+    std::map<std::string, Row>::const_iterator it = listing.rows.begin();
+
+    rows.reserve(count);
+    if (query.sort == SORT_NAME) {
+        std::advance(it, first);
+        for (size_t i = 0; i < count; ++i, ++it) {
+            rows.push_back(&it->second);
+        }
+        return;
+    }
+    std::vector<SortKey> keys(total);
+    for (size_t i = 0; it != listing.rows.end(); ++it, ++i) {
+        const DirectoryEntry& entry = it->second.entry;
+        keys[i].isDir = entry.isDir;
+        keys[i].value = query.sort == SORT_MTIME ? entry.mtime : (entry.isDir ? 0 : entry.size);
+        keys[i].row = &it->second;
+    }
+    // Two selections cut the page out of the unsorted keys in linear time;
+    // only the page itself is then sorted.
+    std::vector<SortKey>::iterator pageBegin = keys.begin() + first;
+    std::vector<SortKey>::iterator pageEnd = pageBegin + count;
+    if (pageBegin != keys.begin() && pageBegin != keys.end()) {
+        std::nth_element(keys.begin(), pageBegin, keys.end(), sortKeyLess);
+    }
+    if (pageEnd != keys.end() && pageBegin != pageEnd) {
+        std::nth_element(pageBegin, pageEnd, keys.end(), sortKeyLess);
+    }
+    std::sort(pageBegin, pageEnd, sortKeyLess);
+    for (; pageBegin != pageEnd; ++pageBegin) {
+        rows.push_back(pageBegin->row);
+    }
+}
+
+static std::string pageLink(const ListingQuery& query, size_t offset, const char* label) {
+    static const char* const sortNames[] = { "name", "size", "mtime" };
+    std::string href = "?sort=" + std::string(sortNames[query.sort]) + "&amp;offset=" + numberToString(offset);
+    if (query.limit != std::string::npos) {
+        href += "&amp;limit=" + numberToString(query.limit);
+    }
+    return "<a href=\"" + href + "\">" + label + "</a>";
+}
+
+// The whole listing in name order is kept with the listing and shared until
+// its rows change; any other page is rendered for the one request.
+SharedBuffer DirectoryListing::renderPage(const std::string& dirPath, Listing& listing, const ListingQuery& query) {
+    size_t total = listing.rows.size();
+    bool whole = query.sort == SORT_NAME && query.offset == 0 && query.limit >= total;
+    if (whole && !listing.page[query.format].empty()) {
+        return listing.page[query.format];
+    }
+
+    std::vector<const Row*> rows;
+    selectRows(listing, query, rows);
+    size_t first = std::min(query.offset, total);
+    std::string body;
+    body.reserve((whole ? listing.rowBytes : rows.size() * 256) + 4096);
+    if (query.format == LISTING_JSON) {
+        body += "{\"path\":\"" + jsonEscape(listing.uri) + "\",\"total\":" + numberToString(total)
+            + ",\"offset\":" + numberToString(first) + ",\"entries\":[";
+        for (size_t i = 0; i < rows.size(); ++i) {
+            if (i > 0) body += ',';
+            body += rows[i]->json;
+        }
+        body += "]}\n";
+    } else {
+        body += HTML_HEAD_START + listing.uri + HTML_HEAD_STYLE + listing.uri + "</h1>\n"
+            + "            <div class=\"path\">" + dirPath + HTML_TABLE_START;
+        if (listing.uri != "/" && listing.uri != "") {
+            body += HTML_PARENT_ROW;
+        }
+        for (size_t i = 0; i < rows.size(); ++i) {
+            body += rows[i]->html;
+        }
+        size_t end = first + rows.size();
+        if (first > 0 || end < total) {
+            body += "                <tr>\n                    <td>";
+            if (first > 0) {
+                size_t previous = query.limit < first ? first - query.limit : 0;
+                body += pageLink(query, previous, "&laquo; Previous");
+            }
+            if (end < total) {
+                body += (first > 0 ? " " : "") + pageLink(query, end, "Next &raquo;");
+            }
+            std::string shown = rows.empty() ? "0" : numberToString(first + 1) + "-" + numberToString(end);
+            body += "</td>\n                    <td class=\"size\">" + shown + " of " + numberToString(total)
+                + "</td>\n                </tr>\n";
+        }
+        body += HTML_TAIL;
+    }
+    SharedBuffer page = SharedBuffer::adopt(body);
+    if (whole) {
+        listing.page[query.format] = page;
+    }
+    return page;
+}
+
+size_t DirectoryListing::cost(const Listing& listing) {
+    return listing.rowBytes + listing.rows.size() * sizeof(Row)
+        + listing.page[LISTING_HTML].size() + listing.page[LISTING_JSON].size();
+}
+
+void DirectoryListing::erase(std::map<std::string, Listing>::iterator it) {
+    if (it->second.watch >= 0) {
+        inotify_rm_watch(s_inotifyFd, it->second.watch);
+        s_watches.erase(it->second.watch);
+    }
+    s_bytes -= cost(it->second);
+    s_lru.erase(it->second.lruPosition);
+    s_listings.erase(it);
+}
+
+void DirectoryListing::trim() {
+    while (!s_lru.empty() && s_bytes > s_maxBytes) {
+        erase(s_listings.find(s_lru.back()));
+    }
+}
+
+// Reads whatever the kernel has queued without blocking. Each changed name
+// is stat()ed once however many events it produced; a lost event (queue
+// overflow) or a watch that went away drops the listings concerned.
+void DirectoryListing::drainEvents() {
+    if (s_inotifyFd < 0 || s_watches.empty()) {
+        return;
+    }
+    union {
+        struct inotify_event event;
+        char bytes[16 * 1024];
+    } buffer;
+    std::map<int, std::set<std::string> > changed;
+    std::set<int> dropped;
+    bool overflow = false;
+    ssize_t n;
+
+    while ((n = ::read(s_inotifyFd, buffer.bytes, sizeof(buffer.bytes))) > 0) {
+        for (ssize_t pos = 0; pos < n; ) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(buffer.bytes + pos);
+            pos += sizeof(struct inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+            } else if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_UNMOUNT | IN_IGNORED)) {
+                dropped.insert(event->wd);
+            } else if (event->len > 0) {
+                changed[event->wd].insert(event->name);
+            }
+        }
+    }
+    if (overflow) {
+        while (!s_lru.empty()) {
+            erase(s_listings.find(s_lru.back()));
+        }
+        return;
+    }
+
+    for (std::set<int>::iterator it = dropped.begin(); it != dropped.end(); ++it) {
+        std::map<int, std::string>::iterator watch = s_watches.find(*it);
+        if (watch != s_watches.end()) {
+            erase(s_listings.find(watch->second));
+        }
+    }
+    std::map<int, std::set<std::string> >::iterator it = changed.begin();
+    for (; it != changed.end(); ++it) {
+        std::map<int, std::string>::iterator watch = s_watches.find(it->first);
+        if (watch == s_watches.end()) {
+            continue;
+        }
+        const std::string& dirPath = watch->second;
+        Listing& listing = s_listings[dirPath];
+        s_bytes -= cost(listing);
+        for (std::set<std::string>::iterator name = it->second.begin(); name != it->second.end(); ++name) {
+            setRow(listing, dirPath, *name);
+        }
+        s_bytes += cost(listing);
+    }
+}
+
+// Fills page with the listing of dirPath as linked from uri. Returns false if
+// the directory cannot be read.
+bool DirectoryListing::render(const std::string& dirPath, const std::string& uri,
+                              const ListingQuery& query, SharedBuffer& page) {
+    if (s_maxBytes == 0) {
+        Listing listing;
+        listing.uri = uri;
+        if (!readDirectory(dirPath, listing)) {
+            return false;
+        }
+        page = renderPage(dirPath, listing, query);
+        return true;
+    }
+
+    drainEvents();
+    std::map<std::string, Listing>::iterator it = s_listings.find(dirPath);
+    if (it != s_listings.end() && it->second.watch < 0) {
+        struct stat st;
+        if (stat(dirPath.c_str(), &st) != 0 || st.st_dev != it->second.device
+            || st.st_ino != it->second.inode || !sameTime(st.st_mtim, it->second.mtime)
+            || !sameTime(st.st_ctim, it->second.ctime)) {
+            erase(it);
+            it = s_listings.end();
+        }
+    }
+
+    if (it == s_listings.end()) {
+        it = s_listings.insert(std::make_pair(dirPath, Listing())).first;
+        Listing& listing = it->second;
+        listing.uri = uri;
+        s_lru.push_front(dirPath);
+        listing.lruPosition = s_lru.begin();
+        // Watched before it is read, so nothing changed in between is missed.
+        if (s_inotifyFd < 0) {
+            s_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        }
+        if (s_inotifyFd >= 0) {
+            int watch = inotify_add_watch(s_inotifyFd, dirPath.c_str(), WATCH_MASK);
+            // The same directory reached through another path shares the
+            // watch; that listing keeps it and this one checks the mtime.
+            if (watch >= 0 && s_watches.find(watch) == s_watches.end()) {
+                listing.watch = watch;
+                s_watches[watch] = dirPath;
+            }
+        }
+        if (!readDirectory(dirPath, listing)) {
+            erase(it);
+            return false;
+        }
+        s_bytes += cost(listing);
+    } else {
+        s_lru.splice(s_lru.begin(), s_lru, it->second.lruPosition);
+    }
+
+    Listing& listing = it->second;
+    s_bytes -= cost(listing);
+    if (listing.uri != uri) {
+        listing.uri = uri;
+        listing.rowBytes = 0;
+        for (std::map<std::string, Row>::iterator row = listing.rows.begin(); row != listing.rows.end(); ++row) {
+            renderRow(uri, row->second);
+            listing.rowBytes += row->first.size() + row->second.html.size() + row->second.json.size();
+        }
+        listing.page[LISTING_HTML] = SharedBuffer();
+        listing.page[LISTING_JSON] = SharedBuffer();
+    }
+    page = renderPage(dirPath, listing, query);
+    s_bytes += cost(listing);
+    trim();
+    return true;
+}
@@ -0,0 +1,108 @@
+#ifndef DIRECTORYLISTING_HPP
+#define DIRECTORYLISTING_HPP
+
+#include "../../../../include/webserv.hpp"
+#include "../../response/SharedBuffer.hpp"
+#include <list>
+#include <stdint.h>
+#include <sys/stat.h>
+
+struct DirectoryEntry {
+    std::string name;
+    bool isDir;
+    off_t size;
+    time_t mtime;
+};
+
+enum ListingFormat {
+    LISTING_HTML,
+    LISTING_JSON
+};
+
+enum ListingSort {
+    SORT_NAME,
+    SORT_SIZE,
+    SORT_MTIME
+};
+
+// Which part of a listing to render. limit is npos for no limit.
+struct ListingQuery {
+    ListingFormat format;
+    ListingSort sort;
+    size_t offset;
+    size_t limit;
+
+    ListingQuery() : format(LISTING_HTML), sort(SORT_NAME), offset(0), limit(std::string::npos) {}
+};
+
+// Per-worker cache of autoindex pages, keyed by directory path and bounded by
+// listing_cache_max_bytes. A directory is read once; every entry keeps its
+// stat() result and its rendered HTML and JSON rows, ordered directories
+// first and then by name. An inotify watch on the directory reports which
+// names changed, and only those are stat()ed and rendered again; the page
+// itself is the fixed head and tail around the rows and is rebuilt only
+// after a change. Without inotify, one stat() of the directory per request
+// checks its mtime and any change rereads it.
+// A page of a listing (offset/limit, or another sort order) is rendered from
+// just its rows: in name order they are reached by walking the map, in size
+// or mtime order they are selected from the unsorted rows and only the page
+// is sorted.
+class DirectoryListing {
+private:
+    struct Row {
+        DirectoryEntry entry;
+        std::string html;
+        std::string json;
+    };
+
+    struct Listing {
+        std::string uri;
+        std::map<std::string, Row> rows;
+        SharedBuffer page[2];
+        int watch;
+        dev_t device;
+        ino_t inode;
+        struct timespec mtime;
+        struct timespec ctime;
+        size_t rowBytes;
+        std::list<std::string>::iterator lruPosition;
+
+        Listing() : watch(-1), rowBytes(0) {}
+    };
+
+    // A row's place in size or mtime order, kept apart from the row so that
+    // selecting a page mostly compares these in one contiguous array.
+    struct SortKey {
+        bool isDir;
+        long long value;
+        const Row* row;
+    };
+
+    static const uint32_t WATCH_MASK;
+
+    static std::map<std::string, Listing> s_listings;
+    static std::list<std::string> s_lru;
+    static std::map<int, std::string> s_watches;
+    static int s_inotifyFd;
+    static size_t s_bytes;
+    static size_t s_maxBytes;
+
+    static bool readDirectory(const std::string& dirPath, Listing& listing);
+    static void setRow(Listing& listing, const std::string& dirPath, const std::string& name);
+    static void renderRow(const std::string& uri, Row& row);
+    static bool sortKeyLess(const SortKey& a, const SortKey& b);
+    static void selectRows(const Listing& listing, const ListingQuery& query, std::vector<const Row*>& rows);
+    static SharedBuffer renderPage(const std::string& dirPath, Listing& listing, const ListingQuery& query);
+    static void drainEvents();
+    static size_t cost(const Listing& listing);
+    static void erase(std::map<std::string, Listing>::iterator it);
+    static void trim();
+    static std::string formatFileSize(off_t bytes);
+
+public:
+    static void configure(size_t maxBytes);
+    static bool render(const std::string& dirPath, const std::string& uri,
+                       const ListingQuery& query, SharedBuffer& page);
+};
+
+#endif
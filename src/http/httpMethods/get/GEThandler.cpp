@@ -1,7 +1,7 @@
 #include "./GEThandler.hpp"
 #include <sys/stat.h>
-#include <dirent.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <string>
 #include <sstream>
 #include <map>
@@ -28,26 +28,6 @@ std::string urlDecode(const std::string &str) {
     return decoded.str();
 }
 
-std::string urlEncode(const std::string &value) {
-    std::ostringstream escaped;
-    escaped.fill('0');
-    escaped << std::hex;
-
-    for (size_t i = 0; i < value.size(); ++i) {
-        char c = value[i];
-        if (isalnum((unsigned char)c) || c == '-' || c == '_' || c == '.' || c == '~') {
-            escaped << c;
-        } else if (c == ' ') {
-            escaped << "%20";
-        } else {
-            escaped << '%' << std::uppercase << std::setw(2) << int((unsigned char)c);
-            escaped << std::nouppercase;
-        }
-    }
-    return escaped.str();
-}
-
-
 std::map<std::string, std::string> parseQueryString(const std::string& query) {
     std::map<std::string, std::string> params;
     std::stringstream ss(query);
@@ -82,6 +62,323 @@ bool fileExists(const std::string& path) {
 bool isFileReadable(const std::string& path) {
     return access(path.c_str(), R_OK) == 0;
 }
+static bool readOpenFile(int fd, size_t size, std::string& content) {
+    content.resize(size);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t bytes = pread(fd, &content[done], size - done, static_cast<off_t>(done));
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            content.clear();
+            return false;
+        }
+        done += static_cast<size_t>(bytes);
+    }
+    return true;
+}
+
+// Strong validator: changes whenever the file is replaced, resized or
+// rewritten, down to mtime's nanoseconds.
+std::string GEThandler::makeETag(const struct stat& st) {
+    char etag[80];
+    snprintf(etag, sizeof(etag), "\"%lx-%lx-%lx.%lx\"",
+             static_cast<unsigned long>(st.st_ino), static_cast<unsigned long>(st.st_size),
+             static_cast<unsigned long>(st.st_mtim.tv_sec), static_cast<unsigned long>(st.st_mtim.tv_nsec));
+    return etag;
+}
+
+static bool etagListMatches(const std::string& list, const std::string& etag) {
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t comma = list.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = list.size();
+        }
+        size_t start = list.find_first_not_of(" \t", pos);
+        size_t end = list.find_last_not_of(" \t", comma - 1);
+        if (start != std::string::npos && start < comma && end != std::string::npos && end >= start) {
+            std::string candidate = list.substr(start, end - start + 1);
+            if (candidate == "*") {
+                return true;
+            }
+            // GET uses the weak comparison, so a W/ prefix does not matter.
+            if (candidate.compare(0, 2, "W/") == 0) {
+                candidate.erase(0, 2);
+            }
+            if (candidate == etag) {
+                return true;
+            }
+        }
+        pos = comma + 1;
+    }
+    return false;
+}
+
+// If-None-Match wins over If-Modified-Since when both are sent (RFC 9110
+// 13.2.2); an unparsable date is ignored.
+bool GEThandler::isNotModified(const Request& req, const std::string& etag, time_t mtime) {
+    if (req.hasHeader("If-None-Match")) {
+        return etagListMatches(req.getHeader("If-None-Match"), etag);
+    }
+    time_t since;
+    if (req.hasHeader("If-Modified-Since") && parseHttpDate(req.getHeader("If-Modified-Since"), since)) {
+        return mtime <= since;
+    }
+    return false;
+}
+
+Response* GEThandler::makeNotModified(const Request& req, const std::string& etag, time_t mtime) {
+    Response* response = new Response();
+    response->setVersion(req.getVersion());
+    response->setServer("WebServer/1.0");
+    response->setDate();
+    response->setStatus(304);
+    response->addHeader("ETag", etag);
+    response->addHeader("Last-Modified", formatHttpDate(mtime));
+    return response;
+}
+
+void GEThandler::setFileHeaders(Response* response, const std::string& path, const std::string& mimeType,
+                                size_t size, const std::string& etag, time_t mtime) {
+    std::map<std::string, std::string> headers;
+    headers["Content-Length"] = numberToString(size);
+    headers["Content-Type"] = mimeType;
+    headers["ETag"] = etag;
+    headers["Last-Modified"] = formatHttpDate(mtime);
+    headers["Accept-Ranges"] = "bytes";
+
+    if (mimeType == "application/octet-stream") {
+        std::string filename = path;
+        size_t lastSlash = path.find_last_of("/\\");
+        if (lastSlash != std::string::npos) {
+            filename = path.substr(lastSlash + 1);
+        }
+        headers["Content-Disposition"] = "attachment; filename=\"" + filename + "\"";
+    }
+    response->setHeaders(headers);
+}
+
+const size_t GEThandler::MAX_RANGES;
+
+static bool parseDecimal(const std::string& text, size_t& value) {
+    if (text.empty() || text.size() > 18) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] < '0' || text[i] > '9') {
+            return false;
+        }
+        value = value * 10 + static_cast<size_t>(text[i] - '0');
+    }
+    return true;
+}
+
+// If-Range needs a strong match: the exact ETag, or a Last-Modified date
+// that is at least a second old, since a file changed twice within that
+// second would carry the same date.
+static bool ifRangeMatches(const std::string& value, const std::string& etag, time_t mtime) {
+    if (value.compare(0, 2, "W/") == 0) {
+        return false;
+    }
+    if (!value.empty() && value[0] == '"') {
+        return value == etag;
+    }
+    time_t date;
+    return parseHttpDate(value, date) && date == mtime && mtime < time(NULL);
+}
+
+// Reads a "bytes=" Range header against a body of size bytes. A header that
+// does not parse, fails If-Range or asks for too many ranges is ignored and
+// the whole body is sent (RFC 9110 14.2).
+RangeResult GEThandler::evaluateRange(const Request& req, size_t size, const std::string& etag,
+                                      time_t mtime, std::vector<ByteRange>& ranges) {
+    if (!req.hasHeader("Range")) {
+        return RANGE_NONE;
+    }
+    if (req.hasHeader("If-Range") && !ifRangeMatches(req.getHeader("If-Range"), etag, mtime)) {
+        return RANGE_NONE;
+    }
+    std::string spec = req.getHeader("Range");
+    if (spec.size() < 6 || !BufferView(spec.data(), 6).equalsIgnoreCase("bytes=")) {
+        return RANGE_NONE;
+    }
+
+    size_t specs = 0;
+    size_t pos = 6;
+    while (pos <= spec.size()) {
+        size_t comma = spec.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = spec.size();
+        }
+        size_t start = spec.find_first_not_of(" \t", pos);
+        pos = comma + 1;
+        if (start == std::string::npos || start >= comma) {
+            continue;
+        }
+        size_t end = spec.find_last_not_of(" \t", comma - 1) + 1;
+        std::string item = spec.substr(start, end - start);
+        size_t dash = item.find('-');
+        if (dash == std::string::npos || ++specs > MAX_RANGES) {
+            return RANGE_NONE;
+        }
+
+        ByteRange range;
+        size_t first;
+        size_t last;
+        if (dash == 0) {
+            if (!parseDecimal(item.substr(1), last)) {
+                return RANGE_NONE;
+            }
+            if (last == 0 || size == 0) {
+                continue;
+            }
+            range.first = (last < size) ? size - last : 0;
+            range.last = size - 1;
+        } else {
+            if (!parseDecimal(item.substr(0, dash), first)) {
+                return RANGE_NONE;
+            }
+            last = size - 1;
+            if (dash + 1 < item.size()
+                && (!parseDecimal(item.substr(dash + 1), last) || last < first)) {
+                return RANGE_NONE;
+            }
+            if (first >= size) {
+                continue;
+            }
+            range.first = first;
+            range.last = std::min(last, size - 1);
+        }
+        ranges.push_back(range);
+    }
+    if (specs == 0) {
+        return RANGE_NONE;
+    }
+    return ranges.empty() ? RANGE_UNSATISFIABLE : RANGE_SATISFIABLE;
+}
+
+static std::string formatContentRange(const ByteRange& range, size_t size) {
+    return "bytes " + numberToString(range.first) + "-" + numberToString(range.last)
+           + "/" + numberToString(size);
+}
+
+// Sends the ranges as a 206, straight from content when the file is in
+// memory and from fd (owned from here on) otherwise. Several ranges become
+// a multipart/byteranges body whose part headers sit between the slices;
+// their file parts all share fd.
+void GEThandler::setRangeBody(Response* response, const std::string& path, const std::string& mimeType,
+                              size_t size, const std::string& etag, time_t mtime,
+                              const std::vector<ByteRange>& ranges, const SharedBuffer& content, int fd) {
+    response->setStatus(206);
+    setFileHeaders(response, path, mimeType, size, etag, mtime);
+
+    std::string boundary;
+    if (ranges.size() > 1) {
+        static unsigned long sequence = 0;
+        char buffer[40];
+        snprintf(buffer, sizeof(buffer), "%08lx%04lx%08lx", static_cast<unsigned long>(time(NULL)),
+                 static_cast<unsigned long>(getpid()) & 0xffff, ++sequence);
+        boundary = buffer;
+        response->addHeader("Content-Type", "multipart/byteranges; boundary=" + boundary);
+    } else {
+        response->addHeader("Content-Range", formatContentRange(ranges[0], size));
+    }
+
+    SharedFile file(fd);
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        const ByteRange& range = ranges[i];
+        size_t length = range.last - range.first + 1;
+        if (!boundary.empty()) {
+            response->addBodyPart("\r\n--" + boundary + "\r\nContent-Type: " + mimeType
+                                  + "\r\nContent-Range: " + formatContentRange(range, size) + "\r\n\r\n");
+        }
+        if (file.isOpen()) {
+            response->addBodyFilePart(file, range.first, length);
+        } else {
+            response->addBodyPart(content, range.first, length);
+        }
+    }
+    if (!boundary.empty()) {
+        response->addBodyPart("\r\n--" + boundary + "--\r\n");
+    }
+    response->addHeader("Content-Length", numberToString(response->getContentSize()));
+}
+
+Response* GEThandler::makeRangeNotSatisfiable(const Request& req, size_t size) {
+    Response* response = Response::makeErrorResponse(416);
+    response->setVersion(req.getVersion());
+    response->addHeader("Content-Range", "bytes */" + numberToString(size));
+    return response;
+}
+
+// Serves a file the FileCache already holds, resolving the path the same
+// way handler() does but without touching the filesystem. Returns NULL when
+// the regular path has to run.
+Response* GEThandler::serveCached(const Request& req, const LocationConfig* location) {
+    std::string uri = req.getURI();
+    size_t queryPos = uri.find('?');
+    if (queryPos != std::string::npos) {
+        uri = uri.substr(0, queryPos);
+    }
+    uri = urlDecode(uri);
+
+    std::string path = FileHandler::mapUriToPath(uri, location);
+    if (!uri.empty() && uri[uri.length() - 1] == '/') {
+        if (!location || location->getIndex().empty()) {
+            return NULL;
+        }
+        if (path[path.length() - 1] != '/') {
+            path += "/";
+        }
+        path += location->getIndex();
+    }
+    if (path.find("..") != std::string::npos) {
+        return NULL;
+    }
+
+    CachedFile cached;
+    if (!FileCache::lookup(path, cached)) {
+        return NULL;
+    }
+    unsigned sidecars = cached.sidecars;
+    ContentCoding coding = ContentEncoding::choose(sidecars, ContentEncoding::accepted(req.getHeader("Accept-Encoding")));
+    if (coding != CODING_IDENTITY && !FileCache::lookup(path + ContentEncoding::suffix(coding), cached)) {
+        return NULL;
+    }
+    Response* response = serveCachedFile(req, path, cached);
+    setCodingHeaders(response, sidecars, coding);
+    return response;
+}
+
+Response* GEThandler::serveCachedFile(const Request& req, const std::string& path, const CachedFile& cached) {
+    if (isNotModified(req, cached.etag, cached.mtime)) {
+        return makeNotModified(req, cached.etag, cached.mtime);
+    }
+    std::vector<ByteRange> ranges;
+    RangeResult range = evaluateRange(req, cached.content.size(), cached.etag, cached.mtime, ranges);
+    if (range == RANGE_UNSATISFIABLE) {
+        return makeRangeNotSatisfiable(req, cached.content.size());
+    }
+
+    Response* response = new Response();
+    response->setVersion(req.getVersion());
+    response->setServer("WebServer/1.0");
+    response->setDate();
+    if (range == RANGE_SATISFIABLE) {
+        setRangeBody(response, path, cached.mimeType, cached.content.size(), cached.etag, cached.mtime,
+                     ranges, cached.content, -1);
+        return response;
+    }
+    response->setStatus(200);
+    setFileHeaders(response, path, cached.mimeType, cached.content.size(), cached.etag, cached.mtime);
+    response->setBody(cached.content);
+    response->setCacheFilePath(path);
+    return response;
+}
+
 Response* GEThandler::handler(const Request& req, const LocationConfig* location, const ServerConfig* /* serverConfig */) {
     Response* response = new Response();
 
@@ -89,7 +386,6 @@ Response* GEThandler::handler(const Request& req, const LocationConfig* location
         response->setVersion(req.getVersion());
         response->setServer("WebServer/1.0");
         response->setDate();
-        response->setConnection("close");
 
         std::string uri = req.getURI();
         std::string queryString;
@@ -151,7 +447,7 @@ Response* GEThandler::handler(const Request& req, const LocationConfig* location
                     
                     if (autoindex) {
                         delete response;
-                        return generateDirectoryListing(uri, dirPath, req);
+                        return generateDirectoryListing(uri, dirPath, queryString, req);
                     } else {
                         delete response;
                         return createErrorResponse(403, "Forbidden");
@@ -161,7 +457,7 @@ Response* GEThandler::handler(const Request& req, const LocationConfig* location
                 
                 if (autoindex) {
                     delete response;
-                    return generateDirectoryListing(uri, dirPath, req);
+                    return generateDirectoryListing(uri, dirPath, queryString, req);
                 } else {
                     delete response;
                     return createErrorResponse(403, "Forbidden");
@@ -189,37 +485,47 @@ Response* GEThandler::handler(const Request& req, const LocationConfig* location
             }
         }
 
-        std::ifstream file(path.c_str(), std::ios::binary);
-        if (!file.is_open()) {
+        int fileFd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fileFd < 0) {
             delete response;
             return createErrorResponse(404, "Not Found");
         }
-
-        std::ostringstream bodyBuffer;
-        bodyBuffer << file.rdbuf();
-        std::string responseBody = bodyBuffer.str();
-        file.close();
+        struct stat fileStat;
+        if (fstat(fileFd, &fileStat) != 0 || !S_ISREG(fileStat.st_mode)) {
+            close(fileFd);
+            delete response;
+            return createErrorResponse(403, "Forbidden");
+        }
+        delete response;
+        response = NULL;
 
         std::string mimeType = MimeType::getMimeType(path);
-
-
-        std::map<std::string, std::string> headers;
-        headers["Content-Length"] = numberToString(responseBody.size());
-        headers["Content-Type"] = mimeType;
-        
-        if (mimeType == "application/octet-stream") {
-            std::string filename = path;
-            size_t lastSlash = path.find_last_of("/\\");
-            if (lastSlash != std::string::npos) {
-                filename = path.substr(lastSlash + 1);
+        unsigned sidecars = ContentEncoding::findSidecars(path, fileStat);
+        ContentCoding coding = ContentEncoding::choose(sidecars, ContentEncoding::accepted(req.getHeader("Accept-Encoding")));
+        std::string filePath = path;
+        if (coding != CODING_IDENTITY) {
+            // Cached along with its sidecars, the plain file lets the next
+            // request negotiate without a stat().
+            SharedBuffer unused;
+            cacheOpenFile(path, fileFd, fileStat, mimeType, sidecars, false, unused);
+            std::string sidecarPath = path + ContentEncoding::suffix(coding);
+            int sidecarFd = open(sidecarPath.c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat sidecarStat;
+            if (sidecarFd >= 0 && fstat(sidecarFd, &sidecarStat) == 0 && S_ISREG(sidecarStat.st_mode)) {
+                close(fileFd);
+                fileFd = sidecarFd;
+                fileStat = sidecarStat;
+                filePath = sidecarPath;
+            } else {
+                if (sidecarFd >= 0) {
+                    close(sidecarFd);
+                }
+                coding = CODING_IDENTITY;
             }
-            headers["Content-Disposition"] = "attachment; filename=\"" + filename + "\"";
         }
-
-        response->setStatus(200);
-        response->setHeaders(headers);
-        response->setBody(responseBody);
-
+        response = serveOpenFile(req, path, filePath, fileFd, fileStat, mimeType,
+                                 coding == CODING_IDENTITY ? sidecars : 0);
+        setCodingHeaders(response, sidecars, coding);
         return response;
 
     } catch (const std::exception& e) {
@@ -228,182 +534,138 @@ Response* GEThandler::handler(const Request& req, const LocationConfig* location
     }
 }
 
-Response* GEThandler::generateDirectoryListing(const std::string& uri, 
-                                               const std::string& dirPath,
-                                               const Request& req) {
+// Reads a small file into FileCache. content is left empty when the file
+// is not cached.
+bool GEThandler::cacheOpenFile(const std::string& path, int fd, const struct stat& st,
+                               const std::string& mimeType, unsigned sidecars, bool isSidecar,
+                               SharedBuffer& content) {
+    std::string data;
+    size_t size = static_cast<size_t>(st.st_size);
+    if (!FileCache::accepts(size) || !readOpenFile(fd, size, data)) {
+        return false;
+    }
+    CachedFile cached;
+    cached.content = SharedBuffer::adopt(data);
+    cached.mimeType = mimeType;
+    cached.etag = makeETag(st);
+    cached.mtime = st.st_mtime;
+    cached.sidecars = sidecars;
+    cached.isSidecar = isSidecar;
+    FileCache::store(path, st, cached);
+    content = cached.content;
+    return true;
+}
+
+// Answers from the open file at filePath, which is path itself or one of its
+// precompressed sidecars. Takes ownership of fd.
+Response* GEThandler::serveOpenFile(const Request& req, const std::string& path, const std::string& filePath,
+                                    int fd, const struct stat& st, const std::string& mimeType, unsigned sidecars) {
+    std::string etag = makeETag(st);
+    if (isNotModified(req, etag, st.st_mtime)) {
+        close(fd);
+        return makeNotModified(req, etag, st.st_mtime);
+    }
+
+    size_t fileSize = static_cast<size_t>(st.st_size);
+    std::vector<ByteRange> ranges;
+    RangeResult range = evaluateRange(req, fileSize, etag, st.st_mtime, ranges);
+    if (range == RANGE_UNSATISFIABLE) {
+        close(fd);
+        return makeRangeNotSatisfiable(req, fileSize);
+    }
+
+    SharedBuffer body;
+    if (cacheOpenFile(filePath, fd, st, mimeType, sidecars, filePath != path, body)) {
+        close(fd);
+        fd = -1;
+    }
 
     Response* response = new Response();
     response->setVersion(req.getVersion());
     response->setServer("WebServer/1.0");
     response->setDate();
-    response->setConnection("close");
-
-    DIR* dir = opendir(dirPath.c_str());
-    if (!dir) {
-        delete response;
-        return createErrorResponse(500, "Cannot read directory");
+    if (range == RANGE_SATISFIABLE) {
+        setRangeBody(response, path, mimeType, fileSize, etag, st.st_mtime, ranges, body, fd);
+        return response;
     }
+    if (fd < 0) {
+        response->setBody(body);
+    } else {
+        // The body stays in the file; the client sends it with sendfile().
+        response->setBodyFile(fd, 0, fileSize);
+    }
+    response->setStatus(200);
+    setFileHeaders(response, path, mimeType, fileSize, etag, st.st_mtime);
+    return response;
+}
 
+// Every answer for a file with sidecars depends on Accept-Encoding, so
+// shared caches have to key on it too.
+void GEThandler::setCodingHeaders(Response* response, unsigned sidecars, ContentCoding coding) {
+    if (sidecars != 0) {
+        response->addHeader("Vary", "Accept-Encoding");
+    }
+    if (coding != CODING_IDENTITY && (response->getStatus() == 200 || response->getStatus() == 206)) {
+        response->addHeader("Content-Encoding", ContentEncoding::name(coding));
+    }
+}
 
-    std::vector<DirectoryEntry> entries;
-
-    struct dirent* entry;
-    while ((entry = readdir(dir)) != NULL) {
-        std::string name = entry->d_name;
-
-        if (name[0] == '.') continue;
-
-        DirectoryEntry dirEntry;
-        dirEntry.name = name;
-
-        std::string fullPath = dirPath + name;
-        struct stat statbuf;
-        if (stat(fullPath.c_str(), &statbuf) == 0) {
-            dirEntry.isDir = S_ISDIR(statbuf.st_mode);
-            dirEntry.size = statbuf.st_size;
-        } else {
-            dirEntry.isDir = false;
-            dirEntry.size = 0;
-        }
-
-        entries.push_back(dirEntry);
-    }
-    closedir(dir);
-
-    std::sort(entries.begin(), entries.end(), compareEntries);
-
-    std::ostringstream html;
-    html << "<!DOCTYPE html>\n";
-    html << "<html lang=\"en\">\n";
-    html << "<head>\n";
-    html << "    <meta charset=\"UTF-8\">\n";
-    html << "    <meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">\n";
-    html << "    <title>Index of " << uri << "</title>\n";
-    html << "    <style>\n";
-    html << "        * { margin: 0; padding: 0; box-sizing: border-box; }\n";
-    html << "        body { font-family: 'Segoe UI', Arial, sans-serif; background: #f5f5f5; padding: 20px; }\n";
-    html << "        .container { max-width: 1000px; margin: 0 auto; background: white; border-radius: 8px; box-shadow: 0 2px 10px rgba(0,0,0,0.1); }\n";
-    html << "        .header { background: linear-gradient(135deg, #667eea 0%, #764ba2 100%); color: white; padding: 30px; border-radius: 8px 8px 0 0; }\n";
-    html << "        h1 { font-size: 1.8em; margin-bottom: 5px; }\n";
-    html << "        .path { opacity: 0.9; font-size: 0.9em; }\n";
-    html << "        table { width: 100%; border-collapse: collapse; }\n";
-    html << "        th { background: #f8f9fa; padding: 15px; text-align: left; font-weight: 600; color: #333; border-bottom: 2px solid #dee2e6; }\n";
-    html << "        td { padding: 12px 15px; border-bottom: 1px solid #e9ecef; }\n";
-    html << "        tr:hover { background: #f8f9fa; }\n";
-    html << "        a { color: #667eea; text-decoration: none; font-weight: 500; }\n";
-    html << "        a:hover { text-decoration: underline; }\n";
-    html << "        .icon { display: inline-block; width: 20px; margin-right: 8px; }\n";
-    html << "        .dir { color: #ffc107; }\n";
-    html << "        .file { color: #667eea; }\n";
-    html << "        .size { color: #666; font-size: 0.9em; }\n";
-    html << "        .footer { padding: 20px; text-align: center; color: #999; font-size: 0.9em; border-top: 1px solid #e9ecef; }\n";
-    html << "    </style>\n";
-    html << "</head>\n";
-    html << "<body>\n";
-    html << "    <div class=\"container\">\n";
-    html << "        <div class=\"header\">\n";
-    html << "            <h1>📁 Index of " << uri << "</h1>\n";
-    html << "            <div class=\"path\">" << dirPath << "</div>\n";
-    html << "        </div>\n";
-    html << "        <table>\n";
-    html << "            <thead>\n";
-    html << "                <tr>\n";
-    html << "                    <th>Name</th>\n";
-    html << "                    <th>Size</th>\n";
-    html << "                </tr>\n";
-    html << "            </thead>\n";
-    html << "            <tbody>\n";
-
-    if (uri != "/" && uri != "") {
-        html << "                <tr>\n";
-        html << "                    <td><span class=\"icon dir\">📁</span><a href=\"../\">Parent Directory</a></td>\n";
-        html << "                    <td class=\"size\">-</td>\n";
-        html << "                </tr>\n";
-    }
-
-
-    for (size_t i = 0; i < entries.size(); ++i) {
-        const DirectoryEntry& e = entries[i];
-
-        std::string baseUri = uri;
-        if (baseUri[baseUri.length() - 1] != '/') {
-            baseUri += "/";
-        }
-
-        std::string href = baseUri + urlEncode(e.name);
-        if (e.isDir) href += "/";
-
-        html << "                <tr>\n";
-        html << "                    <td>";
-
-        if (e.isDir) {
-            html << "<span class=\"icon dir\">📁</span>";
-            html << "<a href=\"" << href << "\">" << e.name << "/</a>";
-        } else {
-            html << "<span class=\"icon file\">📄</span>";
-            html << "<a href=\"" << href << "\">" << e.name << "</a>";
-        }
-
-        html << "</td>\n";
-        html << "                    <td class=\"size\">";
-
-        if (e.isDir) {
-            html << "-";
-        } else {
-            html << formatFileSize(e.size);
+// ?format=json, or an Accept header that asks for JSON and not HTML, gets the
+// listing as JSON for API clients. ?sort=name|size|mtime, ?offset= and
+// ?limit= select one page of it.
+Response* GEThandler::generateDirectoryListing(const std::string& uri,
+                                               const std::string& dirPath,
+                                               const std::string& queryString,
+                                               const Request& req) {
+    std::map<std::string, std::string> params = parseQueryString(queryString);
+    std::map<std::string, std::string>::const_iterator param = params.find("format");
+    BufferView accept = req.getHeader("Accept");
+    ListingQuery query;
+    if (param != params.end() ? param->second == "json"
+        : accept.containsIgnoreCase("application/json") && !accept.containsIgnoreCase("text/html")) {
+        query.format = LISTING_JSON;
+    }
+    param = params.find("sort");
+    if (param != params.end()) {
+        if (param->second == "size") {
+            query.sort = SORT_SIZE;
+        } else if (param->second == "mtime") {
+            query.sort = SORT_MTIME;
+        } else if (param->second != "name") {
+            return createErrorResponse(400, "Bad Request");
         }
-
-        html << "</td>\n";
-        html << "                </tr>\n";
+    }
+    param = params.find("offset");
+    if (param != params.end() && !parseDecimal(param->second, query.offset)) {
+        return createErrorResponse(400, "Bad Request");
+    }
+    param = params.find("limit");
+    if (param != params.end() && !parseDecimal(param->second, query.limit)) {
+        return createErrorResponse(400, "Bad Request");
     }
 
+    SharedBuffer body;
+    if (!DirectoryListing::render(dirPath, uri, query, body)) {
+        return createErrorResponse(500, "Cannot read directory");
+    }
 
-    html << "            </tbody>\n";
-    html << "        </table>\n";
-    html << "        <div class=\"footer\">\n";
-    html << "            WebServer/1.0\n";
-    html << "        </div>\n";
-    html << "    </div>\n";
-    html << "</body>\n";
-    html << "</html>\n";
-
-    std::string body = html.str();
-
-    response->setStatus(200);
-    response->setBody(body);
+    Response* response = new Response();
+    response->setVersion(req.getVersion());
+    response->setServer("WebServer/1.0");
+    response->setDate();
+    response->setConnection("close");
 
     std::map<std::string, std::string> headers;
-    headers["Content-Type"] = "text/html; charset=utf-8";
-    headers["Content-Length"] = numberToString(body.length());
+    headers["Content-Type"] = query.format == LISTING_JSON ? "application/json" : "text/html; charset=utf-8";
+    headers["Content-Length"] = numberToString(body.size());
+    headers["Vary"] = "Accept";
     response->setHeaders(headers);
 
-
+    response->setStatus(200);
+    response->setBody(body);
     return response;
 }
 
-std::string GEThandler::formatFileSize(off_t bytes) {
-    std::ostringstream oss;
-    
-    if (bytes < 1024) {
-        oss << bytes << " B";
-    } else if (bytes < 1024 * 1024) {
-        oss << (bytes / 1024.0) << " KB";
-    } else if (bytes < 1024 * 1024 * 1024) {
-        oss << (bytes / (1024.0 * 1024.0)) << " MB";
-    } else {
-        oss << (bytes / (1024.0 * 1024.0 * 1024.0)) << " GB";
-    }
-    
-    return oss.str();
-}
-
-bool GEThandler::compareEntries(const DirectoryEntry& a, const DirectoryEntry& b) {
-    if (a.isDir && !b.isDir) return true;
-    if (!a.isDir && b.isDir) return false;
-    
-    return a.name < b.name;
-}
-
 Response* GEThandler::createErrorResponse(int statusCode, const std::string& message) {
     Response* response = new Response();
     response->setStatus(statusCode);
@@ -5,11 +5,20 @@
 #include "../../response/HttpMethodHandler.hpp"
 #include "../utils/MimeType.hpp"
 #include "../utils/FileHandler.hpp"
+#include "../utils/FileCache.hpp"
+#include "../utils/ContentEncoding.hpp"
+#include "DirectoryListing.hpp"
 
-struct DirectoryEntry {
-    std::string name;
-    bool isDir;
-    off_t size;
+// Inclusive byte offsets of one satisfiable range of a file.
+struct ByteRange {
+    size_t first;
+    size_t last;
+};
+
+enum RangeResult {
+    RANGE_NONE,
+    RANGE_SATISFIABLE,
+    RANGE_UNSATISFIABLE
 };
 
 class GEThandler : public HttpMethodHandler {
@@ -18,14 +27,36 @@ public:
     ~GEThandler();
 
     Response* handler(const Request& req, const LocationConfig* location, const ServerConfig* serverConfig);
+    static Response* serveCached(const Request& req, const LocationConfig* location);
 
 private:
+    // More ranges than this in one request are ignored and the whole file is
+    // sent, which bounds the work a single header can ask for.
+    static const size_t MAX_RANGES = 16;
+
     Response* generateDirectoryListing(const std::string& uri,
                                        const std::string& dirPath,
+                                       const std::string& queryString,
                                        const Request& req);
     Response* createErrorResponse(int statusCode, const std::string& message);
-    static bool compareEntries(const DirectoryEntry& a, const DirectoryEntry& b);
-    static std::string formatFileSize(off_t bytes);
+    Response* serveOpenFile(const Request& req, const std::string& path, const std::string& filePath,
+                            int fd, const struct stat& st, const std::string& mimeType, unsigned sidecars);
+    static Response* serveCachedFile(const Request& req, const std::string& path, const CachedFile& cached);
+    static bool cacheOpenFile(const std::string& path, int fd, const struct stat& st,
+                              const std::string& mimeType, unsigned sidecars, bool isSidecar,
+                              SharedBuffer& content);
+    static void setCodingHeaders(Response* response, unsigned sidecars, ContentCoding coding);
+    static void setFileHeaders(Response* response, const std::string& path, const std::string& mimeType,
+                               size_t size, const std::string& etag, time_t mtime);
+    static std::string makeETag(const struct stat& st);
+    static bool isNotModified(const Request& req, const std::string& etag, time_t mtime);
+    static Response* makeNotModified(const Request& req, const std::string& etag, time_t mtime);
+    static RangeResult evaluateRange(const Request& req, size_t size, const std::string& etag,
+                                     time_t mtime, std::vector<ByteRange>& ranges);
+    static void setRangeBody(Response* response, const std::string& path, const std::string& mimeType,
+                             size_t size, const std::string& etag, time_t mtime,
+                             const std::vector<ByteRange>& ranges, const SharedBuffer& content, int fd);
+    static Response* makeRangeNotSatisfiable(const Request& req, size_t size);
 };
 
 #endif
\ No newline at end of file
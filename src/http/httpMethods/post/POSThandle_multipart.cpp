@@ -34,31 +34,13 @@ Response* POSThandler::handleMultipartFormData(const Request& /* req */, Respons
             std::string originalFilename = part.getFileName();
             std::string contentType = part.getContentType();
             
-            size_t fileSize;
-            bool hasBinaryData = false;
-            
-            try {
-                const std::vector<char>& binaryData = part.getBinaryData();
-                fileSize = binaryData.size();
-                hasBinaryData = !binaryData.empty();
-            } catch (...) {
-                fileSize = part.getRawData().size();
-                hasBinaryData = false;
-            }
+            size_t fileSize = part.getDataSize();
             
             responseBody += "<p><strong>Original Filename:</strong> " + originalFilename + "</p>";
             responseBody += "<p><strong>Content-Type:</strong> " + contentType + "</p>";
             responseBody += "<p><strong>File Size:</strong> " + numberToString(fileSize) + " bytes</p>";
             
-            std::string savedFilename;
-            if (hasBinaryData) {
-                const std::vector<char>& binaryData = part.getBinaryData();
-                savedFilename = FileHandler::saveUploadedBinaryFile(originalFilename, binaryData);
-            } else {
-                std::string textData = part.getRawData();
-                savedFilename = FileHandler::saveUploadedFile(originalFilename, textData);
-            }
-            
+            std::string savedFilename = part.getSavedFileName();
             if (!savedFilename.empty()) {
                 uploadedFiles.push_back(savedFilename);
                 responseBody += "<p><strong>Status:</strong> <span style='color: green;'>✓ Uploaded Successfully</span></p>";
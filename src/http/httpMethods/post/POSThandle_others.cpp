@@ -1,19 +1,26 @@
 #include "./POSThandler.hpp"
 #include "../../../../include/GlobalUtils.hpp"
 
+static std::string bodyPreview(const Request& req, size_t limit) {
+    std::string preview(std::min(limit, req.getBodySize()), '\0');
+    if (!preview.empty()) {
+        preview.resize(req.getBodySink().readAt(0, &preview[0], preview.size()));
+    }
+    return preview;
+}
+
 Response* POSThandler::handlePlainText(const Request& req, Response* response, const std::string& uri) {
-    std::string textData = req.getRawBody();
+    size_t textLength = req.getBodySize();
     
     std::string responseBody = "POST Success - Plain Text\n";
     responseBody += "URI: " + uri + "\n";
-    responseBody += "Received: " + numberToString(textData.length()) + " bytes of text data\n\n";
+    responseBody += "Received: " + numberToString(textLength) + " bytes of text data\n\n";
     
-    if (textData.length() > 0) {
+    if (textLength > 0) {
         responseBody += "Content Preview:\n";
         responseBody += "================\n";
-        std::string preview = textData.substr(0, 500);
-        responseBody += preview;
-        if (textData.length() > 500) {
+        responseBody += bodyPreview(req, 500);
+        if (textLength > 500) {
             responseBody += "\n... (truncated)";
         }
     } else {
@@ -63,8 +70,7 @@ Response* POSThandler::handleBinaryData(const Request& req, Response* response,
         }
         responseBody += "</ul>";
     } else {
-        std::string rawData = req.getRawBody();
-        totalBytes = rawData.length();
+        totalBytes = req.getBodySize();
         responseBody += "<p>Raw binary data: " + numberToString(totalBytes) + " bytes</p>";
     }
     
@@ -85,25 +91,24 @@ Response* POSThandler::handleBinaryData(const Request& req, Response* response,
 }
 
 Response* POSThandler::handleDefaultPost(const Request& req, Response* response, const std::string& uri) {
-    std::string rawBody = req.getRawBody();
-    std::map<std::string, std::string> headers = req.getHeaders();
+    size_t bodyLength = req.getBodySize();
     
     std::string responseBody = "<html><body><h1>POST Received</h1>";
     responseBody += "<h2>Request Details:</h2>";
     responseBody += "<p><strong>URI:</strong> " + uri + "</p>";
-    responseBody += "<p><strong>Method:</strong> " + req.getMethod() + "</p>";
-    responseBody += "<p><strong>Version:</strong> " + req.getVersion() + "</p>";
-    responseBody += "<p><strong>Content Length:</strong> " + numberToString(rawBody.length()) + " bytes</p>";
+    responseBody += "<p><strong>Method:</strong> " + req.getMethod().str() + "</p>";
+    responseBody += "<p><strong>Version:</strong> " + req.getVersion().str() + "</p>";
+    responseBody += "<p><strong>Content Length:</strong> " + numberToString(bodyLength) + " bytes</p>";
     
     responseBody += "<h3>Headers:</h3><ul>";
-    std::map<std::string, std::string>::const_iterator it;
-    for (it = headers.begin(); it != headers.end(); ++it) {
-        responseBody += "<li><strong>" + it->first + ":</strong> " + it->second + "</li>";
+    for (size_t i = 0; i < req.getHeaderCount(); ++i) {
+        responseBody += "<li><strong>" + req.getHeaderName(i).str() + ":</strong> " + req.getHeaderValue(i).str() + "</li>";
     }
     responseBody += "</ul>";
     
-    std::map<std::string, std::string> query = req.getQuery();
+    const std::map<std::string, std::string>& query = req.getQuery();
     if (!query.empty()) {
+        std::map<std::string, std::string>::const_iterator it;
         responseBody += "<h3>Query Parameters:</h3><ul>";
         for (it = query.begin(); it != query.end(); ++it) {
             responseBody += "<li><strong>" + it->first + ":</strong> " + it->second + "</li>";
@@ -111,12 +116,11 @@ Response* POSThandler::handleDefaultPost(const Request& req, Response* response,
         responseBody += "</ul>";
     }
     
-    if (rawBody.length() > 0) {
+    if (bodyLength > 0) {
         responseBody += "<h3>Body Preview:</h3>";
         responseBody += "<pre>";
-        std::string preview = rawBody.substr(0, 300);
-        responseBody += preview;
-        if (rawBody.length() > 300) {
+        responseBody += bodyPreview(req, 300);
+        if (bodyLength > 300) {
             responseBody += "\n... (truncated)";
         }
         responseBody += "</pre>";
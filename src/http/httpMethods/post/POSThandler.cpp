@@ -9,23 +9,12 @@ Response* POSThandler::handler(const Request& req, const LocationConfig* locatio
     Response* response = new Response();
     
     try {
-        std::map<std::string, std::string> headers = req.getHeaders();
-        bool hasContentLength = false;
-        
-        for (std::map<std::string, std::string>::const_iterator it = headers.begin(); 
-             it != headers.end(); ++it) {
-            if (toLowerCase(it->first) == "content-length") {
-                hasContentLength = true;
-                break;
-            }
-        }
-        
-        if (!hasContentLength) {
+        if (!req.isChunked() && !req.hasHeader("Content-Length")) {
             delete response;
             return createErrorResponse(411, "Length Required");
         }
         
-        std::string contentType = getContentType(headers);
+        std::string contentType = req.getHeader("Content-Type");
         if (contentType.empty()) {
             delete response;
             return createErrorResponse(400, "Bad Request - Missing Content-Type header");
@@ -78,7 +67,7 @@ Response* POSThandler::handler(const Request& req, const LocationConfig* locatio
     }
 }
 
-std::string POSThandler::getUploadDirectory(const LocationConfig* location) const {
+std::string POSThandler::getUploadDirectory(const LocationConfig* location) {
     if (location) {
         std::string uploadStore = location->getUploadStore();
         if (!uploadStore.empty()) {
@@ -96,18 +85,6 @@ std::string POSThandler::getUploadDirectory(const LocationConfig* location) cons
 
 
 
-std::string POSThandler::getContentType(const std::map<std::string, std::string>& headers) {
-    std::map<std::string, std::string>::const_iterator it;
-    for (it = headers.begin(); it != headers.end(); ++it) {
-        std::string headerName = toLowerCase(it->first);
-        if (headerName == "content-type") {
-            return it->second;
-        }
-    }
-    return "";
-}
-
-
 Response* POSThandler::createErrorResponse(int statusCode, const std::string& message) {
     Response* response = new Response();
     response->setStatus(statusCode);
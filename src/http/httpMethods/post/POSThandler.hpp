@@ -29,11 +29,10 @@ private:
     
     Response* handleDefaultPost(const Request& req, Response* response, const std::string& uri);
     
-    std::string getContentType(const std::map<std::string, std::string>& headers);
     
     Response* createErrorResponse(int statusCode, const std::string& message);
-    std::string getUploadDirectory(const LocationConfig* location) const;
 
 public:
+    static std::string getUploadDirectory(const LocationConfig* location);
     Response* handler(const Request& req, const LocationConfig* location, const ServerConfig* serverConfig);
 };
\ No newline at end of file
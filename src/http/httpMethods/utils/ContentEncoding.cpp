@@ -0,0 +1,109 @@
+#include "ContentEncoding.hpp"
+#include <cstdlib>
+#include <cctype>
+
+static const ContentCoding CODINGS[] = { CODING_BR, CODING_GZIP };
+static const size_t CODING_COUNT = sizeof(CODINGS) / sizeof(CODINGS[0]);
+
+// A sidecar older than the file it was made from is stale and ignored.
+unsigned ContentEncoding::findSidecars(const std::string& path, const struct stat& st) {
+    unsigned found = 0;
+    for (size_t i = 0; i < CODING_COUNT; ++i) {
+        struct stat sidecar;
+        if (stat((path + suffix(CODINGS[i])).c_str(), &sidecar) == 0 && S_ISREG(sidecar.st_mode)
+            && sidecar.st_mtime >= st.st_mtime) {
+            found |= CODINGS[i];
+        }
+    }
+    return found;
+}
+
+static bool isZeroQuality(const std::string& params) {
+    size_t q = params.find("q=");
+    if (q == std::string::npos) {
+        return false;
+    }
+    return std::strtod(params.c_str() + q + 2, NULL) <= 0.0;
+}
+
+static ContentCoding codingFromName(const std::string& token) {
+    std::string lower;
+    for (size_t i = 0; i < token.size(); ++i) {
+        lower += static_cast<char>(std::tolower(static_cast<unsigned char>(token[i])));
+    }
+    if (lower == "gzip" || lower == "x-gzip") {
+        return CODING_GZIP;
+    }
+    if (lower == "br") {
+        return CODING_BR;
+    }
+    return CODING_IDENTITY;
+}
+
+// Codings listed with a non-zero q, plus those "*" covers that are not
+// listed themselves (RFC 9110 12.5.3).
+unsigned ContentEncoding::accepted(const std::string& acceptEncoding) {
+    unsigned listed = 0;
+    unsigned accepted = 0;
+    bool wildcard = false;
+    size_t pos = 0;
+    
+    while (pos < acceptEncoding.size()) {
+        size_t comma = acceptEncoding.find(',', pos);
+        if (comma == std::string::npos) {
+            comma = acceptEncoding.size();
+        }
+        std::string item = acceptEncoding.substr(pos, comma - pos);
+        pos = comma + 1;
+        
+        size_t semicolon = item.find(';');
+        std::string params = (semicolon == std::string::npos) ? "" : item.substr(semicolon + 1);
+        std::string token = item.substr(0, semicolon);
+        size_t start = token.find_first_not_of(" \t");
+        if (start == std::string::npos) {
+            continue;
+        }
+        token = token.substr(start, token.find_last_not_of(" \t") - start + 1);
+        bool allowed = !isZeroQuality(params);
+        
+        if (token == "*") {
+            wildcard = allowed;
+            continue;
+        }
+        ContentCoding coding = codingFromName(token);
+        listed |= coding;
+        if (allowed) {
+            accepted |= coding;
+        }
+    }
+    if (wildcard) {
+        accepted |= (CODING_GZIP | CODING_BR) & ~listed;
+    }
+    return accepted;
+}
+
+// Brotli is preferred: it is the smaller of the two for text.
+ContentCoding ContentEncoding::choose(unsigned sidecars, unsigned accepted) {
+    for (size_t i = 0; i < CODING_COUNT; ++i) {
+        if (sidecars & accepted & CODINGS[i]) {
+            return CODINGS[i];
+        }
+    }
+    return CODING_IDENTITY;
+}
+
+const char* ContentEncoding::suffix(ContentCoding coding) {
+    switch (coding) {
+        case CODING_GZIP: return ".gz";
+        case CODING_BR: return ".br";
+        default: return "";
+    }
+}
+
+const char* ContentEncoding::name(ContentCoding coding) {
+    switch (coding) {
+        case CODING_GZIP: return "gzip";
+        case CODING_BR: return "br";
+        default: return "identity";
+    }
+}
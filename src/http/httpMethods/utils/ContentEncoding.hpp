@@ -0,0 +1,26 @@
+#ifndef CONTENTENCODING_HPP
+#define CONTENTENCODING_HPP
+
+#include "../../../../include/webserv.hpp"
+#include <sys/stat.h>
+
+// Bit values, so a set of codings (those a client accepts, or those a file
+// has a precompressed copy in) fits in an unsigned.
+enum ContentCoding {
+    CODING_IDENTITY = 0,
+    CODING_GZIP = 1,
+    CODING_BR = 2
+};
+
+// Precompressed static files: "file.gz" / "file.br" next to "file" are
+// served instead of it to clients that accept that coding.
+class ContentEncoding {
+public:
+    static unsigned findSidecars(const std::string& path, const struct stat& st);
+    static unsigned accepted(const std::string& acceptEncoding);
+    static ContentCoding choose(unsigned sidecars, unsigned accepted);
+    static const char* suffix(ContentCoding coding);
+    static const char* name(ContentCoding coding);
+};
+
+#endif
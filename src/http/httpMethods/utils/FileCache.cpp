@@ -0,0 +1,94 @@
+#include "FileCache.hpp"
+#include "ContentEncoding.hpp"
+#include "../../../server/TimerWheel.hpp"
+
+const size_t FileCache::MAX_ENTRY_SIZE;
+
+std::map<std::string, FileCache::Entry> FileCache::s_entries;
+std::list<std::string> FileCache::s_lru;
+size_t FileCache::s_bytes = 0;
+size_t FileCache::s_maxBytes = 0;
+long FileCache::s_validMs = 0;
+
+void FileCache::configure(size_t maxBytes, long validMs) {
+    s_maxBytes = maxBytes;
+    s_validMs = validMs;
+    while (!s_lru.empty() && s_bytes > s_maxBytes) {
+        erase(s_entries.find(s_lru.back()));
+    }
+}
+
+// A single file may take at most a quarter of the cache, so one large file
+// cannot flush the whole hot set.
+bool FileCache::accepts(size_t size) {
+    return s_maxBytes > 0 && size <= MAX_ENTRY_SIZE && size <= s_maxBytes / 4;
+}
+
+static bool sameTime(const struct timespec& a, const struct timespec& b) {
+    return a.tv_sec == b.tv_sec && a.tv_nsec == b.tv_nsec;
+}
+
+bool FileCache::matches(const Entry& entry, const struct stat& st) {
+    return S_ISREG(st.st_mode) && st.st_dev == entry.device && st.st_ino == entry.inode
+        && st.st_size == entry.size && sameTime(st.st_mtim, entry.mtime)
+        && sameTime(st.st_ctim, entry.ctime);
+}
+
+void FileCache::erase(std::map<std::string, Entry>::iterator it) {
+    s_bytes -= it->second.file.content.size();
+    s_lru.erase(it->second.lruPosition);
+    s_entries.erase(it);
+}
+
+bool FileCache::lookup(const std::string& path, CachedFile& file) {
+    std::map<std::string, Entry>::iterator it = s_entries.find(path);
+    if (it == s_entries.end()) {
+        return false;
+    }
+    
+    Entry& entry = it->second;
+    long now = TimerWheel::now();
+    if (now - entry.validatedAt >= s_validMs) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !matches(entry, st)
+            || (!entry.file.isSidecar && ContentEncoding::findSidecars(path, st) != entry.file.sidecars)) {
+            erase(it);
+            return false;
+        }
+        entry.validatedAt = now;
+    }
+    
+    s_lru.splice(s_lru.begin(), s_lru, entry.lruPosition);
+    file = entry.file;
+    return true;
+}
+
+void FileCache::store(const std::string& path, const struct stat& st, const CachedFile& file) {
+    size_t size = file.content.size();
+    if (!accepts(size)) {
+        return;
+    }
+    invalidate(path);
+    while (!s_lru.empty() && s_bytes + size > s_maxBytes) {
+        erase(s_entries.find(s_lru.back()));
+    }
+    
+    s_lru.push_front(path);
+    Entry& entry = s_entries[path];
+    entry.file = file;
+    entry.device = st.st_dev;
+    entry.inode = st.st_ino;
+    entry.size = st.st_size;
+    entry.mtime = st.st_mtim;
+    entry.ctime = st.st_ctim;
+    entry.validatedAt = TimerWheel::now();
+    entry.lruPosition = s_lru.begin();
+    s_bytes += size;
+}
+
+void FileCache::invalidate(const std::string& path) {
+    std::map<std::string, Entry>::iterator it = s_entries.find(path);
+    if (it != s_entries.end()) {
+        erase(it);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef FILECACHE_HPP
+#define FILECACHE_HPP
+
+#include "../../../../include/webserv.hpp"
+#include "../../response/SharedBuffer.hpp"
+#include <list>
+#include <sys/stat.h>
+
+struct CachedFile {
+    SharedBuffer content;
+    std::string mimeType;
+    std::string etag;
+    time_t mtime;
+    unsigned sidecars;
+    bool isSidecar;
+
+    CachedFile() : mtime(0), sidecars(0), isSidecar(false) {}
+};
+
+// Per-worker LRU cache of small static files, keyed by resolved path and
+// bounded by file_cache_max_bytes. An entry is trusted without any syscall
+// for file_cache_valid ms after it was last checked; after that one stat()
+// confirms it (inode, size, mtime and ctime unchanged) or drops it. The
+// precompressed sidecars recorded with an original file are looked up again
+// at that point, so negotiating a coding costs no syscall in between; an
+// entry that is itself a sidecar has none to look up.
+// Larger files are not cached: they go out with sendfile() uncopied.
+class FileCache {
+private:
+    struct Entry {
+        CachedFile file;
+        dev_t device;
+        ino_t inode;
+        off_t size;
+        struct timespec mtime;
+        struct timespec ctime;
+        long validatedAt;
+        std::list<std::string>::iterator lruPosition;
+    };
+
+    static const size_t MAX_ENTRY_SIZE = 1024 * 1024;
+
+    static std::map<std::string, Entry> s_entries;
+    static std::list<std::string> s_lru;
+    static size_t s_bytes;
+    static size_t s_maxBytes;
+    static long s_validMs;
+
+    static bool matches(const Entry& entry, const struct stat& st);
+    static void erase(std::map<std::string, Entry>::iterator it);
+
+public:
+    static void configure(size_t maxBytes, long validMs);
+    static bool accepts(size_t size);
+    static bool lookup(const std::string& path, CachedFile& file);
+    static void store(const std::string& path, const struct stat& st, const CachedFile& file);
+    static void invalidate(const std::string& path);
+};
+
+#endif
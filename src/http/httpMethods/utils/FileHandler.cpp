@@ -46,8 +46,12 @@ std::string FileHandler::sanitizeFilename(const std::string& filename) {
 }
 
 std::string FileHandler::generateUniqueFilename(const std::string& originalFilename) {
+    return generateUniqueFilename(uploadDirectory, originalFilename);
+}
+
+std::string FileHandler::generateUniqueFilename(const std::string& directory, const std::string& originalFilename) {
     std::string sanitized = sanitizeFilename(originalFilename);
-    std::string fullPath = uploadDirectory + "/" + sanitized;
+    std::string fullPath = directory + "/" + sanitized;
     struct stat buffer;
     
     if (stat(fullPath.c_str(), &buffer) != 0) {
@@ -70,7 +74,7 @@ std::string FileHandler::generateUniqueFilename(const std::string& originalFilen
         oss.str("");
         oss << baseName << "_" << counter << extension;
         std::string uniqueName = oss.str();
-        fullPath = uploadDirectory + "/" + uniqueName;
+        fullPath = directory + "/" + uniqueName;
         counter++;
     }
     
@@ -117,61 +121,6 @@ bool FileHandler::readBinaryFile(const std::string& filepath, std::vector<char>&
 
 
 
-std::string FileHandler::saveUploadedBinaryFile(const std::string& originalFilename, 
-                                               const std::vector<char>& binaryData) {
-    
-    if (binaryData.empty()) {
-        return "";
-    }
-    
-    std::string savedFilename = generateUniqueFilename(originalFilename);
-    std::string fullPath = uploadDirectory + "/" + savedFilename;
-    
-    
-    std::ofstream file(fullPath.c_str(), std::ios::binary);
-    if (!file.is_open()) {
-        return "";
-    }
-    
-    file.write(&binaryData[0], binaryData.size());
-    
-    if (file.fail()) {
-        file.close();
-        return "";
-    }
-    
-    file.close();
-    return savedFilename;
-}
-
-std::string FileHandler::saveUploadedFile(const std::string& originalFilename, 
-                                         const std::string& data) {
-    
-    if (data.empty()) {
-        return "";
-    }
-    
-    std::string savedFilename = generateUniqueFilename(originalFilename);
-    std::string fullPath = uploadDirectory + "/" + savedFilename;
-    
-    
-    std::ofstream file(fullPath.c_str(), std::ios::binary);
-    if (!file.is_open()) {
-        return "";
-    }
-    
-    file.write(data.c_str(), data.size());
-    
-    if (file.fail()) {
-        file.close();
-        return "";
-    }
-    
-    file.close();
-    
-    return savedFilename;
-}
-
 std::string FileHandler::getFileName(const std::string& filepath) {
     size_t pos = filepath.find_last_of("/\\");
     if (pos != std::string::npos) {
@@ -184,7 +133,7 @@ std::string FileHandler::getFileName(const std::string& filepath) {
 
 
 
-std::string FileHandler::resolveFilePath(const std::string &uri, const LocationConfig *location)
+std::string FileHandler::mapUriToPath(const std::string &uri, const LocationConfig *location)
 {
     std::string root = "www";
     std::string locationPath = "/";
@@ -224,6 +173,13 @@ std::string FileHandler::resolveFilePath(const std::string &uri, const LocationC
         fullPath += "/" + relativeUri;
     }
 
+    return fullPath;
+}
+
+std::string FileHandler::resolveFilePath(const std::string &uri, const LocationConfig *location)
+{
+    std::string fullPath = mapUriToPath(uri, location);
+
     struct stat pathStat;
     if (stat(fullPath.c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode))
     {
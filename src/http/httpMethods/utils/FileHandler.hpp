@@ -12,19 +12,16 @@ public:
     static void setUploadDirectory(const std::string& dir);
     static std::string getUploadDirectory();
     
-    static std::string saveUploadedBinaryFile(const std::string& originalFilename, 
-                                             const std::vector<char>& binaryData);
-    static std::string saveUploadedFile(const std::string& originalFilename, 
-                                       const std::string& data);
-    
     static bool fileExists(const std::string& filename);
     static bool readFile(const std::string& filepath, std::string& content);
     static bool readBinaryFile(const std::string& filepath, std::vector<char>& content);
     
     static std::string generateUniqueFilename(const std::string& originalFilename);
+    static std::string generateUniqueFilename(const std::string& directory, const std::string& originalFilename);
     static std::string sanitizeFilename(const std::string& filename);
     static std::string getFileName(const std::string& filepath);
 
+    static std::string mapUriToPath(const std::string& uri, const LocationConfig* location);
     static std::string resolveFilePath(const std::string& uri, const LocationConfig* location);
 };
 
@@ -0,0 +1,104 @@
+#include "BodySink.hpp"
+#include <sys/mman.h>
+
+BodySink::BodySink() : memoryLimit(0), fd(-1), length(0), mapping(NULL) {}
+
+BodySink::~BodySink() {
+    if (mapping) {
+        munmap(mapping, length);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+void BodySink::open(size_t expectedSize, size_t memoryLimit, const std::string& tempDir) {
+    this->memoryLimit = memoryLimit;
+    this->tempDir = tempDir;
+    if (expectedSize <= memoryLimit) {
+        memory.reserve(expectedSize);
+    } else {
+        createFile();
+    }
+}
+
+void BodySink::createFile() {
+    std::string pattern = tempDir + "/webserv-body-XXXXXX";
+    std::vector<char> path(pattern.begin(), pattern.end());
+    path.push_back('\0');
+
+    fd = mkostemp(&path[0], O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to create request body file in " + tempDir + ": " + strerror(errno));
+    }
+    unlink(&path[0]);
+}
+
+void BodySink::write(const char* data, size_t size) {
+    if (fd < 0 && length + size > memoryLimit) {
+        createFile();
+        writeFile(memory.data(), memory.size());
+        std::string().swap(memory);
+    }
+    if (fd < 0) {
+        memory.append(data, size);
+    } else {
+        writeFile(data, size);
+    }
+    length += size;
+}
+
+void BodySink::writeFile(const char* data, size_t size) {
+    size_t written = 0;
+    while (written < size) {
+        ssize_t result = ::write(fd, data + written, size - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Failed to write request body: ") + strerror(errno));
+        }
+        written += static_cast<size_t>(result);
+    }
+}
+
+size_t BodySink::readAt(size_t offset, char* buffer, size_t count) const {
+    if (offset >= length) {
+        return 0;
+    }
+    count = std::min(count, length - offset);
+
+    if (fd < 0) {
+        std::memcpy(buffer, memory.data() + offset, count);
+        return count;
+    }
+
+    ssize_t result;
+    do {
+        result = pread(fd, buffer, count, static_cast<off_t>(offset));
+    } while (result < 0 && errno == EINTR);
+    if (result < 0) {
+        throw std::runtime_error(std::string("Failed to read request body: ") + strerror(errno));
+    }
+    return static_cast<size_t>(result);
+}
+
+// File-backed bodies are mapped read-only on first use, so handlers that
+// need the whole body at once read it from the page cache rather than from
+// a heap copy.
+BufferView BodySink::view() const {
+    if (fd < 0) {
+        return BufferView(memory.data(), length);
+    }
+    if (length == 0) {
+        return BufferView();
+    }
+    if (!mapping) {
+        void* mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            throw std::runtime_error(std::string("Failed to map request body: ") + strerror(errno));
+        }
+        mapping = mapped;
+    }
+    return BufferView(static_cast<const char*>(mapping), length);
+}
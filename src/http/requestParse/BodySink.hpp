@@ -0,0 +1,40 @@
+#ifndef BODY_SINK_HPP
+#define BODY_SINK_HPP
+
+#include "../../../include/webserv.hpp"
+#include "BufferView.hpp"
+
+// Destination of a request body. Bodies up to the memory limit are kept in
+// a buffer; larger ones are written to an anonymous (already unlinked) temp
+// file, so a connection's memory stays bounded whatever the upload size.
+// A body of unknown length (chunked) starts in memory and moves to the file
+// once it outgrows the limit.
+class BodySink {
+private:
+    std::string memory;
+    size_t memoryLimit;
+    std::string tempDir;
+    int fd;
+    size_t length;
+    mutable void* mapping;
+
+    BodySink(const BodySink&);
+    BodySink& operator=(const BodySink&);
+
+    void createFile();
+    void writeFile(const char* data, size_t size);
+
+public:
+    BodySink();
+    ~BodySink();
+
+    void open(size_t expectedSize, size_t memoryLimit, const std::string& tempDir);
+    void write(const char* data, size_t size);
+
+    size_t size() const { return length; }
+    bool isInMemory() const { return fd < 0; }
+    size_t readAt(size_t offset, char* buffer, size_t count) const;
+    BufferView view() const;
+};
+
+#endif
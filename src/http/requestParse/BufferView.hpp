@@ -0,0 +1,50 @@
+#ifndef BUFFER_VIEW_HPP
+#define BUFFER_VIEW_HPP
+
+#include <string>
+#include <cstring>
+#include <cctype>
+#include <strings.h>
+
+// Non-owning pointer/length slice of a buffer. Only valid while the buffer
+// it points into is alive and unmodified.
+class BufferView {
+private:
+    const char* ptr;
+    size_t len;
+
+public:
+    BufferView() : ptr(NULL), len(0) {}
+    BufferView(const char* data, size_t size) : ptr(data), len(size) {}
+
+    const char* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+    char operator[](size_t index) const { return ptr[index]; }
+
+    std::string str() const { return len ? std::string(ptr, len) : std::string(); }
+    operator std::string() const { return str(); }
+
+    bool operator==(const char* other) const {
+        size_t otherLen = std::strlen(other);
+        return otherLen == len && std::memcmp(ptr, other, len) == 0;
+    }
+    bool operator!=(const char* other) const { return !(*this == other); }
+
+    bool equalsIgnoreCase(const char* other) const {
+        size_t otherLen = std::strlen(other);
+        return otherLen == len && strncasecmp(ptr, other, len) == 0;
+    }
+
+    bool containsIgnoreCase(const char* needle) const {
+        size_t needleLen = std::strlen(needle);
+        for (size_t i = 0; i + needleLen <= len; ++i) {
+            if (strncasecmp(ptr + i, needle, needleLen) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif
@@ -0,0 +1,117 @@
+#include "ChunkedDecoder.hpp"
+
+const size_t ChunkedDecoder::MAX_SIZE_DIGITS;
+const size_t ChunkedDecoder::MAX_LINE_SIZE;
+
+ChunkedDecoder::ChunkedDecoder()
+    : state(CHUNK_SIZE), chunkRemaining(0), sizeDigits(0), lineLength(0), trailerSize(0) {}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return 10 + (c - 'a');
+    if (c >= 'A' && c <= 'F')
+        return 10 + (c - 'A');
+    return -1;
+}
+
+bool ChunkedDecoder::decode(const char* data, size_t size, size_t& used, BufferView& payload) {
+    used = 0;
+    payload = BufferView();
+    
+    while (used < size && state != CHUNK_DONE) {
+        if (state == CHUNK_DATA) {
+            size_t take = std::min(chunkRemaining, size - used);
+            payload = BufferView(data + used, take);
+            used += take;
+            chunkRemaining -= take;
+            if (chunkRemaining == 0) {
+                state = CHUNK_DATA_CR;
+            }
+            return true;
+        }
+        
+        char c = data[used++];
+        switch (state) {
+            case CHUNK_SIZE: {
+                int digit = hexValue(c);
+                if (digit >= 0) {
+                    if (++sizeDigits > MAX_SIZE_DIGITS) {
+                        return false;
+                    }
+                    chunkRemaining = chunkRemaining * 16 + static_cast<size_t>(digit);
+                    break;
+                }
+                if (sizeDigits == 0) {
+                    return false;
+                }
+                if (c == ';' || c == ' ' || c == '\t') {
+                    state = CHUNK_EXTENSION;
+                } else if (c == '\r') {
+                    state = CHUNK_SIZE_LF;
+                } else {
+                    return false;
+                }
+                break;
+            }
+            case CHUNK_EXTENSION:
+                if (++lineLength > MAX_LINE_SIZE) {
+                    return false;
+                }
+                if (c == '\r') {
+                    state = CHUNK_SIZE_LF;
+                }
+                break;
+            case CHUNK_SIZE_LF:
+                if (c != '\n') {
+                    return false;
+                }
+                sizeDigits = 0;
+                lineLength = 0;
+                if (chunkRemaining == 0) {
+                    state = CHUNK_TRAILER;
+                } else {
+                    state = CHUNK_DATA;
+                }
+                break;
+            case CHUNK_DATA_CR:
+                if (c != '\r') {
+                    return false;
+                }
+                state = CHUNK_DATA_LF;
+                break;
+            case CHUNK_DATA_LF:
+                if (c != '\n') {
+                    return false;
+                }
+                state = CHUNK_SIZE;
+                break;
+            case CHUNK_TRAILER:
+                // Trailer fields are skipped; an empty line ("\r\n" or
+                // "\n") ends the body.
+                ++trailerSize;
+                if (lineLength == 0 && c == '\r') {
+                    state = CHUNK_TRAILER_LF;
+                } else if (c == '\n') {
+                    if (lineLength == 0) {
+                        state = CHUNK_DONE;
+                    }
+                    lineLength = 0;
+                } else if (++lineLength > MAX_LINE_SIZE) {
+                    return false;
+                }
+                break;
+            case CHUNK_TRAILER_LF:
+                ++trailerSize;
+                if (c != '\n') {
+                    return false;
+                }
+                state = CHUNK_DONE;
+                break;
+            default:
+                return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef CHUNKED_DECODER_HPP
+#define CHUNKED_DECODER_HPP
+
+#include "../../../include/webserv.hpp"
+#include "BufferView.hpp"
+
+enum ChunkedState {
+    CHUNK_SIZE,
+    CHUNK_EXTENSION,
+    CHUNK_SIZE_LF,
+    CHUNK_DATA,
+    CHUNK_DATA_CR,
+    CHUNK_DATA_LF,
+    CHUNK_TRAILER,
+    CHUNK_TRAILER_LF,
+    CHUNK_DONE
+};
+
+// Incremental decoder for "Transfer-Encoding: chunked". Framing is parsed
+// byte by byte and may be split anywhere across calls; chunk payload is
+// handed back as a view into the caller's input, so decoding copies nothing.
+class ChunkedDecoder {
+public:
+    ChunkedDecoder();
+
+    // Consumes framing up to the next payload bytes (or the end of input)
+    // and returns them through `payload`. `used` counts every byte taken,
+    // framing included. Returns false on malformed input.
+    bool decode(const char* data, size_t size, size_t& used, BufferView& payload);
+    bool isComplete() const { return state == CHUNK_DONE; }
+    // Payload bytes of the current chunk not yet returned.
+    size_t getChunkRemaining() const { return chunkRemaining; }
+    // Bytes of trailer section consumed so far, for the caller to bound.
+    size_t getTrailerSize() const { return trailerSize; }
+
+private:
+    static const size_t MAX_SIZE_DIGITS = 15;
+    static const size_t MAX_LINE_SIZE = 8 * 1024;
+
+    ChunkedState state;
+    size_t chunkRemaining;
+    size_t sizeDigits;
+    size_t lineLength;
+    size_t trailerSize;
+};
+
+#endif
@@ -0,0 +1,194 @@
+#include "MultipartParser.hpp"
+#include "RequestParser.hpp"
+#include "../httpMethods/utils/FileHandler.hpp"
+
+MultipartParser::MultipartParser(const std::string& boundary, const std::string& uploadDir)
+    : delimiter("\r\n--" + boundary), uploadDir(uploadDir), state(MULTIPART_PREAMBLE),
+      matched(2), partSize(0), fileFd(-1) {
+    struct stat st;
+    if (stat(uploadDir.c_str(), &st) == -1) {
+        mkdir(uploadDir.c_str(), 0755);
+    }
+}
+
+MultipartParser::~MultipartParser() {
+    if (fileFd >= 0) {
+        close(fileFd);
+        unlink(filePath.c_str());
+    }
+    if (state != MULTIPART_DONE) {
+        for (size_t i = 0; i < savedPaths.size(); ++i) {
+            unlink(savedPaths[i].c_str());
+        }
+    }
+}
+
+bool MultipartParser::feed(const char* data, size_t size) {
+    size_t pos = 0;
+    
+    while (pos < size && state != MULTIPART_DONE) {
+        if (state == MULTIPART_PREAMBLE || state == MULTIPART_DATA) {
+            pos += scanData(data + pos, size - pos);
+        } else if (state == MULTIPART_DELIMITER_TAIL) {
+            if (!parseDelimiterTail(data[pos++])) {
+                return false;
+            }
+        } else if (!parseHeaderByte(data[pos++])) {
+            return false;
+        }
+    }
+    flushPartData();
+    return true;
+}
+
+// Bytes that may begin a delimiter are held back (as `matched`) until the
+// delimiter either completes or fails to match. The delimiter starts with
+// CR and boundaries cannot contain one, so on a mismatch the held-back
+// prefix is always plain data and scanning resumes at the current byte.
+size_t MultipartParser::scanData(const char* data, size_t size) {
+    size_t i = 0;
+    
+    while (i < size) {
+        if (matched == 0) {
+            const char* cr = static_cast<const char*>(std::memchr(data + i, '\r', size - i));
+            size_t run = cr ? static_cast<size_t>(cr - (data + i)) : size - i;
+            appendPartData(data + i, run);
+            i += run;
+            if (!cr) {
+                break;
+            }
+        }
+        
+        if (data[i] == delimiter[matched]) {
+            ++i;
+            if (++matched == delimiter.size()) {
+                matched = 0;
+                if (state == MULTIPART_DATA) {
+                    endPart();
+                }
+                state = MULTIPART_DELIMITER_TAIL;
+                tail.clear();
+                return i;
+            }
+        } else {
+            appendPartData(delimiter.data(), matched);
+            matched = 0;
+        }
+    }
+    return i;
+}
+
+bool MultipartParser::parseDelimiterTail(char c) {
+    if (tail.empty() && c == '-') {
+        tail = "-";
+        return true;
+    }
+    if (tail == "-") {
+        if (c != '-') {
+            return false;
+        }
+        state = MULTIPART_DONE;
+        return true;
+    }
+    if (tail.empty() && (c == ' ' || c == '\t')) {
+        return true;
+    }
+    if (tail.empty() && c == '\r') {
+        tail = "\r";
+        return true;
+    }
+    if (tail == "\r" && c == '\n') {
+        beginPart();
+        state = MULTIPART_HEADERS;
+        return true;
+    }
+    return false;
+}
+
+bool MultipartParser::parseHeaderByte(char c) {
+    partHeaders += c;
+    if (partHeaders.size() > MAX_PART_HEADER_SIZE) {
+        return false;
+    }
+    
+    size_t length = partHeaders.size();
+    if (partHeaders == "\r\n" || (length >= 4 && partHeaders.compare(length - 4, 4, "\r\n\r\n") == 0)) {
+        RequestParser::parsePartHeaders(partHeaders, part);
+        if (!part.getFileName().empty()) {
+            std::string savedName;
+            for (int attempt = 0; fileFd < 0 && attempt < 16; ++attempt) {
+                savedName = FileHandler::generateUniqueFilename(uploadDir, part.getFileName());
+                filePath = uploadDir + "/" + savedName;
+                fileFd = open(filePath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+                if (fileFd < 0 && errno != EEXIST) {
+                    break;
+                }
+            }
+            if (fileFd < 0) {
+                throw std::runtime_error("Failed to create upload file " + filePath + ": " + strerror(errno));
+            }
+            part.setSavedFileName(savedName);
+        }
+        state = MULTIPART_DATA;
+    }
+    return true;
+}
+
+void MultipartParser::beginPart() {
+    part = RequestBody();
+    partHeaders.clear();
+    partData.clear();
+    partSize = 0;
+}
+
+void MultipartParser::appendPartData(const char* data, size_t size) {
+    if (state != MULTIPART_DATA || size == 0) {
+        return;
+    }
+    partSize += size;
+    partData.append(data, size);
+}
+
+// File data collected during one feed() is written with a single call
+// rather than once per run between CR bytes.
+void MultipartParser::flushPartData() {
+    if (fileFd < 0 || partData.empty()) {
+        return;
+    }
+    
+    size_t written = 0;
+    while (written < partData.size()) {
+        ssize_t result = write(fileFd, partData.data() + written, partData.size() - written);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to write upload file " + filePath + ": " + strerror(errno));
+        }
+        written += static_cast<size_t>(result);
+    }
+    partData.clear();
+}
+
+// An empty file part or one without a field name is not kept, matching what
+// the buffered parser used to report for them.
+void MultipartParser::endPart() {
+    if (fileFd >= 0) {
+        flushPartData();
+        close(fileFd);
+        fileFd = -1;
+        if (partSize == 0 || part.getName().empty()) {
+            unlink(filePath.c_str());
+            part.setSavedFileName("");
+        } else {
+            savedPaths.push_back(filePath);
+        }
+        part.setSavedSize(partSize);
+    } else {
+        part.setRawData(partData);
+    }
+    
+    if (!part.getName().empty()) {
+        parts.push_back(part);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef MULTIPART_PARSER_HPP
+#define MULTIPART_PARSER_HPP
+
+#include "../../../include/webserv.hpp"
+#include "RequestBody.hpp"
+
+enum MultipartState {
+    MULTIPART_PREAMBLE,
+    MULTIPART_DELIMITER_TAIL,
+    MULTIPART_HEADERS,
+    MULTIPART_DATA,
+    MULTIPART_DONE
+};
+
+// Incremental multipart/form-data parser. It is fed the body as it arrives
+// and writes file parts straight into uploadDir, so an upload reaches disk
+// while the client is still sending. A delimiter may be split across any
+// number of feed() calls. Files of a body that never reaches its closing
+// delimiter are removed when the parser is destroyed.
+class MultipartParser {
+public:
+    MultipartParser(const std::string& boundary, const std::string& uploadDir);
+    ~MultipartParser();
+
+    bool feed(const char* data, size_t size);
+    bool isComplete() const { return state == MULTIPART_DONE; }
+    const std::vector<RequestBody>& getParts() const { return parts; }
+
+private:
+    static const size_t MAX_PART_HEADER_SIZE = 8 * 1024;
+
+    std::string delimiter;
+    std::string uploadDir;
+    MultipartState state;
+    size_t matched;
+    std::string tail;
+    std::string partHeaders;
+    RequestBody part;
+    std::string partData;
+    size_t partSize;
+    int fileFd;
+    std::string filePath;
+    std::vector<RequestBody> parts;
+    std::vector<std::string> savedPaths;
+
+    MultipartParser(const MultipartParser&);
+    MultipartParser& operator=(const MultipartParser&);
+
+    size_t scanData(const char* data, size_t size);
+    bool parseDelimiterTail(char c);
+    bool parseHeaderByte(char c);
+    void beginPart();
+    void appendPartData(const char* data, size_t size);
+    void flushPartData();
+    void endPart();
+};
+
+#endif
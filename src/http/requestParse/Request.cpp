@@ -5,261 +5,257 @@
 #include <algorithm>
 #include "../../config/ParseUtils.hpp"
 #include "RequestParser.hpp"
+#include "MultipartParser.hpp"
 #include <cstdio>
 #include <cstring>
 #include <iomanip>
 #include <sstream>
 
-std::vector<std::string> split(const std::string& str, const std::string& delimiter) {
-    std::vector<std::string> tokens;
-    size_t start = 0;
-    size_t end = str.find(delimiter);
+const size_t Request::MAX_HEAD_SIZE;
+const size_t Request::MAX_HEADER_FIELDS;
+
+Request::Request(size_t bodyBufferSize, const std::string& bodyTempPath)
+    : fieldCount(0), parseState(PARSE_REQUEST_HEAD), headTerminatorMatched(0), contentLength(0),
+      chunked(false), bodyLimit(std::numeric_limits<size_t>::max()),
+      bodyBufferSize(bodyBufferSize), bodyTempPath(bodyTempPath), bodyReceived(0), multipart(NULL) {}
+
+Request::~Request() {
+    delete multipart;
+}
+
+void Request::streamMultipart(const std::string& boundary, const std::string& uploadDir) {
+    delete multipart;
+    multipart = new MultipartParser(boundary, uploadDir);
+}
+
+size_t Request::consume(const char* data, size_t size) {
+    size_t used = 0;
     
-    while (end != std::string::npos) {
-        tokens.push_back(str.substr(start, end - start));
-        start = end + delimiter.length();
-        end = str.find(delimiter, start);
+    if (parseState == PARSE_REQUEST_HEAD) {
+        static const char terminator[] = "\r\n\r\n";
+        
+        while (used < size && headTerminatorMatched < 4) {
+            char c = data[used++];
+            if (c == terminator[headTerminatorMatched]) {
+                ++headTerminatorMatched;
+            } else {
+                headTerminatorMatched = (c == '\r') ? 1 : 0;
+            }
+        }
+        raw.append(data, used);
+        
+        if (headTerminatorMatched < 4) {
+            if (raw.size() > MAX_HEAD_SIZE) {
+                throw InvalidRequest();
+            }
+            return used;
+        }
+        parseHead(raw.size() - 4);
+        return used;
     }
     
-    tokens.push_back(str.substr(start));
-    return tokens;
+    if (parseState == PARSE_REQUEST_BODY) {
+        if (chunked) {
+            return consumeChunkedBody(data, size);
+        }
+        size_t take = std::min(contentLength - bodyReceived, size);
+        writeBody(data, take);
+        if (bodyReceived == contentLength) {
+            finishBody();
+        }
+        return take;
+    }
+    return used;
 }
 
-void Request::extractRequestData(std::string rawReqData){
-    std::vector<std::string> parts = split(rawReqData, " ");
+size_t Request::consumeChunkedBody(const char* data, size_t size) {
+    size_t used = 0;
     
-    if (parts.size() < 3) {
-        throw InvalidRequest();
+    while (used < size && !chunkedDecoder.isComplete()) {
+        size_t framed;
+        BufferView payload;
+        if (!chunkedDecoder.decode(data + used, size - used, framed, payload)) {
+            throw InvalidRequest();
+        }
+        used += framed;
+        // Checked against the declared chunk size, so an oversized chunk is
+        // refused before its data arrives.
+        if (payload.size() + chunkedDecoder.getChunkRemaining() > bodyLimit - bodyReceived) {
+            throw PayloadTooLarge();
+        }
+        // Trailer fields are discarded, so they are held to the same bound
+        // as the head rather than to client_max_body_size.
+        if (chunkedDecoder.getTrailerSize() > MAX_HEAD_SIZE) {
+            throw PayloadTooLarge();
+        }
+        writeBody(payload.data(), payload.size());
     }
-
-    method = parts[0];
-    uri = parts[1];
-    version = parts[2];
-}
-
-Request::Request(std::string rawRequest) {
-    if (!isCompleteRequest(rawRequest)) {
-        throw IncompleteRequest();
+    if (chunkedDecoder.isComplete()) {
+        finishBody();
     }
-    
-    parseRawReq(rawRequest);
+    return used;
 }
 
-bool Request::isCompleteRequest(const std::string& rawRequest) const {
-    size_t headerEnd = rawRequest.find("\r\n\r\n");
-    if (headerEnd == std::string::npos) {
-        return false;
+void Request::writeBody(const char* data, size_t size) {
+    if (size == 0) {
+        return;
     }
-    
-    std::string headersSection = rawRequest.substr(0, headerEnd);
-    size_t contentLength = getContentLengthFromHeaders(headersSection);
-    size_t totalHeadersSize = headerEnd + 4;
-    size_t expectedTotalSize = totalHeadersSize + contentLength;
-    
-    bool isComplete = rawRequest.size() >= expectedTotalSize;
-    
-    return isComplete;
+    if (multipart) {
+        if (!multipart->feed(data, size)) {
+            throw InvalidRequest();
+        }
+    } else {
+        if (bodyReceived == 0) {
+            bodySink.open(contentLength, bodyBufferSize, bodyTempPath);
+        }
+        bodySink.write(data, size);
+    }
+    bodyReceived += size;
 }
 
-size_t Request::findHeaderEnd(const std::string& rawRequest) const {
-    return rawRequest.find("\r\n\r\n");
+void Request::finishBody() {
+    if (multipart && !multipart->isComplete()) {
+        throw InvalidRequest();
+    }
+    parseState = PARSE_REQUEST_COMPLETE;
 }
 
-size_t Request::getContentLengthFromHeaders(const std::string& headersSection) const {
-    std::string lowerHeaders = headersSection;
-    std::transform(lowerHeaders.begin(), lowerHeaders.end(), lowerHeaders.begin(), ::tolower);
-    
-    size_t pos = lowerHeaders.find("content-length:");
-    if (pos == std::string::npos) {
+size_t Request::getContentLength() const {
+    BufferView value = getHeader("Content-Length");
+    if (value.empty()) {
         return 0;
     }
-    
-    size_t valueStart = pos + 15;
-    size_t valueEnd = headersSection.find("\r\n", valueStart);
-    
-    if (valueEnd == std::string::npos) {
-        return 0;
+    if (value.size() > 18) {
+        throw InvalidRequest();
     }
-    
-    std::string lengthStr = headersSection.substr(valueStart, valueEnd - valueStart);
-    
-    size_t first = lengthStr.find_first_not_of(" \t");
-    size_t last = lengthStr.find_last_not_of(" \t");
-    if (first != std::string::npos && last != std::string::npos) {
-        lengthStr = lengthStr.substr(first, last - first + 1);
-    } else if (first != std::string::npos) {
-        lengthStr = lengthStr.substr(first);
+    size_t length = 0;
+    for (size_t i = 0; i < value.size(); ++i) {
+        char c = value.data()[i];
+        if (c < '0' || c > '9') {
+            throw InvalidRequest();
+        }
+        length = length * 10 + static_cast<size_t>(c - '0');
     }
-    
-    size_t result = static_cast<size_t>(std::atol(lengthStr.c_str()));
-    
-    return result;
+    return length;
 }
 
-size_t Request::getContentLength() const {
-    std::map<std::string, std::string>::const_iterator it;
-    for (it = headers.begin(); it != headers.end(); ++it) {
-        std::string headerName = it->first;
-        std::transform(headerName.begin(), headerName.end(), headerName.begin(), ::tolower);
-        if (headerName == "content-length") {
-            return static_cast<size_t>(atol(it->second.c_str()));
+void Request::parseHead(size_t headEnd) {
+    size_t lineEnd = raw.find("\r\n");
+    parseRequestLine(0, lineEnd);
+    
+    size_t pos = lineEnd + 2;
+    while (pos < headEnd) {
+        lineEnd = raw.find("\r\n", pos);
+        parseHeaderLine(pos, lineEnd);
+        pos = lineEnd + 2;
+    }
+    
+    BufferView transferEncoding = getHeader("Transfer-Encoding");
+    if (!transferEncoding.empty()) {
+        if (!transferEncoding.equalsIgnoreCase("chunked")) {
+            throw NotSupportedRequest();
         }
+        // Both framings at once is a request smuggling vector, not a body.
+        if (hasHeader("Content-Length")) {
+            throw InvalidRequest();
+        }
+        chunked = true;
     }
-    return 0;
+    contentLength = getContentLength();
+    parseState = hasBody() ? PARSE_REQUEST_BODY : PARSE_REQUEST_COMPLETE;
 }
 
-void Request::parseRawReq(std::string rawRequest) {
-    size_t headerEnd = rawRequest.find("\r\n\r\n");
-    if (headerEnd == std::string::npos) {
+void Request::parseRequestLine(size_t start, size_t end) {
+    size_t methodEnd = raw.find(' ', start);
+    if (methodEnd == std::string::npos || methodEnd >= end) {
         throw InvalidRequest();
     }
-    
-    std::string headersData = rawRequest.substr(0, headerEnd);
-    
-    std::vector<std::string> lines = split(headersData, "\r\n");
-    if (lines.empty()) {
+    size_t uriEnd = raw.find(' ', methodEnd + 1);
+    if (uriEnd == std::string::npos || uriEnd >= end) {
         throw InvalidRequest();
     }
     
-    Request::extractRequestData(lines[0]);
-    
-    std::vector<std::string> headerLines(lines.begin() + 1, lines.end());
-    extractHeaders(headerLines);
-    
-    size_t bodyStart = headerEnd + 4;
-    if (bodyStart < rawRequest.size()) {
-        size_t bodySize = rawRequest.size() - bodyStart;
-        
-        binaryBody.clear();
-        binaryBody.reserve(bodySize);
-        for (size_t i = bodyStart; i < rawRequest.size(); ++i) {
-            binaryBody.push_back(rawRequest[i]);
-        }
-        
-        body = rawRequest.substr(bodyStart);
+    method = RequestSpan(start, methodEnd - start);
+    uri = RequestSpan(methodEnd + 1, uriEnd - methodEnd - 1);
+    version = RequestSpan(uriEnd + 1, end - uriEnd - 1);
+    if (method.length == 0 || uri.length == 0 || version.length == 0
+        || raw.find(' ', uriEnd + 1) < end) {
+        throw InvalidRequest();
     }
 }
 
-void Request::extractBinaryBody(const char* data, size_t size) {
-    binaryBody.clear();
-    binaryBody.reserve(size);
-    
-    for (size_t i = 0; i < size; ++i) {
-        binaryBody.push_back(data[i]);
-    }
-    
-    body.assign(data, size);
+static bool isOptionalWhitespace(char c) {
+    return c == ' ' || c == '\t';
 }
 
-std::vector<std::string> Request::splitHeaderFromBody(std::string rawRequest) {
-    std::vector<std::string> parts;
-    size_t pos = rawRequest.find("\r\n\r\n");
-    
-    if (pos == std::string::npos) {
-        parts.push_back(rawRequest);
-        return parts;
+void Request::parseHeaderLine(size_t start, size_t end) {
+    while (start < end && isOptionalWhitespace(raw[start])) {
+        ++start;
     }
-    
-    std::string headers = rawRequest.substr(0, pos);
-    
-    std::string body = rawRequest.substr(pos + 4);
-    
-    parts.push_back(headers);
-    if (!body.empty()) {
-        parts.push_back(body);
+    if (start == end) {
+        return;
     }
     
-    return parts;
-}
-
-void Request::extractBody(std::string rawBody) {
-    binaryBody.clear();
-    binaryBody.reserve(rawBody.size());
+    size_t colon = raw.find(':', start);
+    if (colon == std::string::npos || colon >= end || fieldCount == MAX_HEADER_FIELDS) {
+        throw InvalidRequest();
+    }
     
-    for (size_t i = 0; i < rawBody.size(); ++i) {
-        binaryBody.push_back(rawBody[i]);
+    size_t nameEnd = colon;
+    while (nameEnd > start && isOptionalWhitespace(raw[nameEnd - 1])) {
+        --nameEnd;
+    }
+    size_t valueStart = colon + 1;
+    while (valueStart < end && isOptionalWhitespace(raw[valueStart])) {
+        ++valueStart;
+    }
+    size_t valueEnd = end;
+    while (valueEnd > valueStart && isOptionalWhitespace(raw[valueEnd - 1])) {
+        --valueEnd;
     }
     
-    body = rawBody;
+    HeaderField& field = fields[fieldCount++];
+    field.name = RequestSpan(start, nameEnd - start);
+    field.value = RequestSpan(valueStart, valueEnd - valueStart);
 }
 
-void Request::extractQuery(std::string queryString) {
-    std::vector<std::string> splitedQuery = ParseUtils::splitString(queryString, '&');
-    std::map<std::string, std::string> outputQuery;
-    std::pair<std::string, std::string> holderQuery;
-
-    for (size_t i = 0; i < splitedQuery.size(); i++) {
-        std::vector<std::string> tmp = ParseUtils::splitString(splitedQuery[i], '=');
-        if (tmp.size() != 2)
-            throw (InvalidRequest());
-        holderQuery = std::make_pair(tmp[0], tmp[1]);
-        outputQuery.insert(holderQuery);
+BufferView Request::getHeader(const char* name) const {
+    for (size_t i = 0; i < fieldCount; ++i) {
+        if (view(fields[i].name).equalsIgnoreCase(name)) {
+            return view(fields[i].value);
+        }
     }
-
-    this->query = outputQuery;
+    return BufferView();
 }
 
-void Request::extractHeaders(std::vector<std::string> splitedHeaders) {
-    for (size_t i = 0; i < splitedHeaders.size(); ++i) {
-        std::string line = ParseUtils::trim(splitedHeaders[i]);
-        if (line.empty())
-            continue;
-
-        size_t colon = line.find(':');
-        if (colon == std::string::npos)
-            throw (InvalidRequest());
-
-        std::string key = ParseUtils::trim(line.substr(0, colon));
-        std::string value = ParseUtils::trim(line.substr(colon + 1));
-        this->headers.insert(std::make_pair(key, value));
+bool Request::hasHeader(const char* name) const {
+    for (size_t i = 0; i < fieldCount; ++i) {
+        if (view(fields[i].name).equalsIgnoreCase(name)) {
+            return true;
+        }
     }
+    return false;
 }
 
-std::map<std::string, std::string> Request::getHeaders() const {
-    return headers;
-}
-
-std::string Request::getMethod() const {
-    return method;
-}
-
-std::string Request::getURI() const {
-    return uri;
-}
-
-std::string Request::getVersion() const {
-    return version;
+bool Request::isKeepAlive() const {
+    BufferView connection = getHeader("Connection");
+    
+    if (getVersion() == "HTTP/1.1") {
+        return !connection.containsIgnoreCase("close");
+    }
+    return connection.containsIgnoreCase("keep-alive");
 }
 
 std::vector<RequestBody> Request::getBody() {
-    if (method == "POST")
+    if (getMethod() == "POST")
         return RequestParser::ParseBody(*this);
     throw (ForbiddenMethod());
 }
 
-std::map<std::string, std::string> Request::getQuery() const {
-    return query;
-}
-
-std::string Request::getRawBody() const {
-    if (!binaryBody.empty()) {
-        return std::string(binaryBody.begin(), binaryBody.end());
-    }
-    return body;
-}
-
-const std::vector<char>& Request::getRawBinaryBody() const {
-    return binaryBody;
-}
-
 const char* Request::InvalidRequest::what() const throw() {
     return ("\033[31m[REQUEST ERROR: INVALID REQUEST!]\033[0m");
 }
 
-const char* Request::IncompleteRequest::what() const throw() {
-    return ("\033[33m[REQUEST WARNING: INCOMPLETE REQUEST!]\033[0m");
-}
-
 const char* Request::ForbiddenMethod::what() const throw() {
     return ("\033[31m[REQUEST ERROR: FORBIDDEN METHOD?]\033[0m");
 }
@@ -267,3 +263,7 @@ const char* Request::ForbiddenMethod::what() const throw() {
 const char* Request::NotSupportedRequest::what() const throw() {
     return ("\033[31m[REQUEST ERROR: NOT SUPPORTED!]\033[0m");
 }
+
+const char* Request::PayloadTooLarge::what() const throw() {
+    return ("\033[31m[REQUEST ERROR: PAYLOAD TOO LARGE!]\033[0m");
+}
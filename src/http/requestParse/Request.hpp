@@ -3,56 +3,120 @@
 
 #include "../../../include/webserv.hpp"
 #include "RequestBody.hpp"
+#include "BufferView.hpp"
+#include "BodySink.hpp"
+#include "ChunkedDecoder.hpp"
 
+class MultipartParser;
+
+enum RequestParseState {
+    PARSE_REQUEST_HEAD,
+    PARSE_REQUEST_BODY,
+    PARSE_REQUEST_COMPLETE
+};
+
+// Offset/length slice of the request head held in Request::raw.
+struct RequestSpan {
+    size_t offset;
+    size_t length;
+
+    RequestSpan() : offset(0), length(0) {}
+    RequestSpan(size_t offset, size_t length) : offset(offset), length(length) {}
+};
+
+struct HeaderField {
+    RequestSpan name;
+    RequestSpan value;
+};
+
+// Request is filled incrementally: consume() takes whatever bytes have
+// arrived, keeps its position across calls and reports how many bytes
+// belong to this request, so each received byte is examined once.
+// The head is kept in a single buffer and every accessor returns a view
+// into it; body bytes go straight to a BodySink, which spills bodies larger
+// than bodyBufferSize to a temp file under bodyTempPath.
+// consume() stops right after the head so the caller can pick where the
+// body goes (e.g. streamMultipart) and its size limit before any body byte
+// is taken. Chunked bodies are decoded on the way in, so everything past
+// consume() only ever sees the decoded body.
 class Request {
 public:
-    Request(std::string rawRequest);
-
-    std::string getMethod() const;
-    std::string getURI() const;
-    std::string getVersion() const;
-    std::string getRawBody() const; 
-    std::map<std::string, std::string> getHeaders() const;
-    std::map<std::string, std::string> getQuery() const;
+    Request(size_t bodyBufferSize, const std::string& bodyTempPath);
+    ~Request();
+
+    size_t consume(const char* data, size_t size);
+    bool isComplete() const { return parseState == PARSE_REQUEST_COMPLETE; }
+    bool isHeadComplete() const { return parseState != PARSE_REQUEST_HEAD; }
+
+    BufferView getMethod() const { return view(method); }
+    BufferView getURI() const { return view(uri); }
+    BufferView getVersion() const { return view(version); }
+    BufferView getRawBody() const { return bodySink.view(); }
+    size_t getBodySize() const { return bodyReceived; }
+    size_t getExpectedBodySize() const { return contentLength; }
+    bool isChunked() const { return chunked; }
+    bool hasBody() const { return chunked || contentLength > 0; }
+    void setBodyLimit(size_t limit) { bodyLimit = limit; }
+    const BodySink& getBodySink() const { return bodySink; }
+    void streamMultipart(const std::string& boundary, const std::string& uploadDir);
+    const MultipartParser* getMultipart() const { return multipart; }
+    BufferView getHeader(const char* name) const;
+    bool hasHeader(const char* name) const;
+    size_t getHeaderCount() const { return fieldCount; }
+    BufferView getHeaderName(size_t index) const { return view(fields[index].name); }
+    BufferView getHeaderValue(size_t index) const { return view(fields[index].value); }
+    bool isKeepAlive() const;
+    const std::map<std::string, std::string>& getQuery() const { return query; }
     std::vector<RequestBody> getBody();
-    const std::vector<char>& getRawBinaryBody() const;
-    const std::vector<char>& getBinaryBody() const { return binaryBody; };
-    void setBinaryBody(const std::vector<char>& data) { binaryBody = data; };
-    void extractBinaryBody(const char* data, size_t size);
 
     class InvalidRequest : public std::exception {
         public: const char* what() const throw();
     };
-    class IncompleteRequest : public std::exception {
-        public: const char* what() const throw();
-    };
     class ForbiddenMethod : public std::exception {
         public: const char* what() const throw();
     };
     class NotSupportedRequest : public std::exception {
         public: const char* what() const throw();
     };
+    class PayloadTooLarge : public std::exception {
+        public: const char* what() const throw();
+    };
 
 private:
-    std::string method;
-    std::string uri;
-    std::string version;
-    std::string body;
-    std::vector<char> binaryBody;  
-    std::map<std::string, std::string> headers;
+    static const size_t MAX_HEAD_SIZE = 64 * 1024;
+    static const size_t MAX_HEADER_FIELDS = 100;
+
+    std::string raw;
+    RequestSpan method;
+    RequestSpan uri;
+    RequestSpan version;
+    HeaderField fields[MAX_HEADER_FIELDS];
+    size_t fieldCount;
     std::map<std::string, std::string> query;
+    RequestParseState parseState;
+    size_t headTerminatorMatched;
+    size_t contentLength;
+    bool chunked;
+    ChunkedDecoder chunkedDecoder;
+    size_t bodyLimit;
+    size_t bodyBufferSize;
+    std::string bodyTempPath;
+    size_t bodyReceived;
+    BodySink bodySink;
+    MultipartParser* multipart;
+
+    Request(const Request&);
+    Request& operator=(const Request&);
 
-    bool isCompleteRequest(const std::string& rawRequest) const;
-    size_t findHeaderEnd(const std::string& rawRequest) const;
-    size_t getContentLengthFromHeaders(const std::string& headersSection) const;
+    BufferView view(const RequestSpan& span) const { return BufferView(raw.data() + span.offset, span.length); }
     size_t getContentLength() const;
+    size_t consumeChunkedBody(const char* data, size_t size);
+    void writeBody(const char* data, size_t size);
+    void finishBody();
 
-    void parseRawReq(std::string rawRequest);
-    void extractRequestData(std::string rawReqData);
-    void extractHeaders(std::vector<std::string> splitedHeaders);
-    void extractBody(std::string rawBody);
-    void extractQuery(std::string queryString);
-    std::vector<std::string> splitHeaderFromBody(std::string rawRequest);
+    void parseHead(size_t headEnd);
+    void parseRequestLine(size_t start, size_t end);
+    void parseHeaderLine(size_t start, size_t end);
 };
 
 #endif 
@@ -3,6 +3,8 @@
 #include "../../config/ParseUtils.hpp"
 #include "RequestParser.hpp"
 
+RequestBody::RequestBody() : savedSize(0) {}
+
 void RequestBody::setName(const std::string &name) {
     this->name = name;
 }
@@ -15,31 +17,16 @@ void RequestBody::setContentType(const std::string &contentType) {
     this->contentType = contentType;
 }
 
-void RequestBody::setBinaryData(const std::vector<char>& data) {
-    binaryData = data;
-    
-    rawData = std::string(data.begin(), data.end());
+void RequestBody::setRawData(const std::string &data) {
+    rawData = data;
 }
 
-void RequestBody::setBinaryData(const char* data, size_t size) {
-    binaryData.clear();
-    binaryData.reserve(size);
-    
-    for (size_t i = 0; i < size; ++i) {
-        binaryData.push_back(data[i]);
-    }
-    
-    rawData.assign(data, size);
+void RequestBody::setSavedFileName(const std::string &name) {
+    savedFileName = name;
 }
 
-void RequestBody::setRawData(const std::string &data) {
-    rawData = data;
-    
-    binaryData.clear();
-    binaryData.reserve(data.size());
-    for (size_t i = 0; i < data.size(); ++i) {
-        binaryData.push_back(data[i]);
-    }
+void RequestBody::setSavedSize(size_t size) {
+    savedSize = size;
 }
 
 void RequestBody::setEncodedData(const std::map<std::string, std::string> &encodedData) {
@@ -62,32 +49,14 @@ std::string RequestBody::getRawData() const {
     return rawData;
 }
 
-const std::vector<char>& RequestBody::getBinaryData() const {
-    return binaryData;
-}
-
-std::string RequestBody::getBinaryDataAsString() const {
-    if (!binaryData.empty()) {
-        return std::string(binaryData.begin(), binaryData.end());
-    }
-    return rawData;
+std::string RequestBody::getSavedFileName() const {
+    return savedFileName;
 }
 
 std::map<std::string, std::string> RequestBody::getEncodedData() const {
     return encodData;
 }
 
-bool RequestBody::isBinaryData() const {
-    if (binaryData.empty()) return false;
-    
-    for (size_t i = 0; i < binaryData.size(); ++i) {
-        if (binaryData[i] == '\0') {
-            return true;
-        }
-    }
-    return false;
-}
-
 size_t RequestBody::getDataSize() const {
-    return binaryData.empty() ? rawData.size() : binaryData.size();
+    return savedFileName.empty() ? rawData.size() : savedSize;
 }
\ No newline at end of file
@@ -5,14 +5,15 @@
 class RequestBody {
 	private:
 		std::string							rawData;
-		 
-		std::vector<char> binaryData;
+		std::string							savedFileName;
+		size_t								savedSize;
 		std::map<std::string, std::string>	encodData;
 		std::string 						name;
 		std::string 						fileName;
 		std::string 						contentType;
 
 	public:
+		RequestBody();
 
 		void					setName(const std::string &name);
 		void					setFileName(const std::string &fileName);
@@ -26,10 +27,10 @@ class RequestBody {
 		std::string							getFileName() const;
 		std::string							getContentType() const;
 
-		void setBinaryData(const std::vector<char>& data);
-    	void setBinaryData(const char* data, size_t size);
-    	const std::vector<char>& getBinaryData() const;
-    	std::string getBinaryDataAsString() const;
-    	bool isBinaryData() const;
+		// File parts are written to the upload store while the body streams
+		// in; only the stored name and size are kept here.
+		void					setSavedFileName(const std::string &name);
+		void					setSavedSize(size_t size);
+		std::string				getSavedFileName() const;
     	size_t getDataSize() const;
 };
\ No newline at end of file
@@ -1,39 +1,22 @@
 #include "RequestParser.hpp"
+#include "MultipartParser.hpp"
 #include "../../config/ParseUtils.hpp"
 #include <iostream>
 #include <sstream>
 
-std::vector<RequestBody> RequestParser::parseMultipartFormData(const Request& req, const std::string& contentType) {
-    
-    std::string boundary = extractBoundary(contentType);
-    if (boundary.empty()) {
-        return std::vector<RequestBody>();
-    }
-    
-    
-    const std::vector<char>& binaryBody = req.getRawBinaryBody();
-    if (binaryBody.empty()) {
-        return std::vector<RequestBody>();
-    }
-    
-    
-    return parseMultipartBinary(binaryBody, boundary);
-}
-
 std::vector<RequestBody> RequestParser::ParseBody(const Request& req) {
     std::vector<RequestBody> bodies;
     
-    std::map<std::string, std::string> headers = req.getHeaders();
-    std::map<std::string, std::string>::iterator it = headers.find("Content-Type");
-    
-    if (it == headers.end()) {
+    std::string contentType = req.getHeader("Content-Type");
+    if (contentType.empty()) {
         return bodies;
     }
     
-    std::string contentType = it->second;
-    
     if (contentType.find("multipart/form-data") != std::string::npos) {
-        return RequestParser::parseMultipartFormData(req, contentType);
+        if (req.getMultipart()) {
+            return req.getMultipart()->getParts();
+        }
+        return bodies;
     } else if (contentType.find("application/x-www-form-urlencoded") != std::string::npos) {
         return RequestParser::parseUrlEncodedData(req);
     }
@@ -43,86 +26,6 @@ std::vector<RequestBody> RequestParser::ParseBody(const Request& req) {
 
 
 
-std::vector<RequestBody> RequestParser::parseMultipartBinary(const std::vector<char>& data, const std::string& boundary)
-{
-    std::vector<RequestBody> bodies;
-    
-    std::string fullBoundary = "--" + boundary;
-    std::string endBoundary = "--" + boundary + "--";
-    
-    
-    std::string dataStr(data.begin(), data.end());
-    
-    std::vector<size_t> boundaryPositions;
-    
-    size_t pos = 0;
-    while ((pos = dataStr.find(fullBoundary, pos)) != std::string::npos) {
-        boundaryPositions.push_back(pos);
-        pos += fullBoundary.length();
-    }
-    
-    if (boundaryPositions.size() < 2) {
-        return bodies;
-    }
-    
-    for (size_t i = 0; i < boundaryPositions.size() - 1; ++i) {
-        size_t partStart = boundaryPositions[i] + fullBoundary.length();
-        size_t partEnd = boundaryPositions[i + 1];
-        
-        if (partStart + 2 < data.size() && data[partStart] == '\r' && data[partStart + 1] == '\n') {
-            partStart += 2;
-        }
-        
-        if (partStart >= partEnd) continue;
-        
-        
-        RequestBody part = parseMultipartPart(data, partStart, partEnd);
-        if (!part.getName().empty()) {
-            bodies.push_back(part);
-        }
-    }
-    
-    return bodies;
-}
-
-RequestBody RequestParser::parseMultipartPart(const std::vector<char>& data, size_t start, size_t end) {
-    RequestBody body;
-    
-    if (start >= end || end > data.size()) {
-        return body;
-    }
-    
-    std::string partStr(data.begin() + start, data.begin() + end);
-    size_t headersEnd = partStr.find("\r\n\r\n");
-    
-    if (headersEnd == std::string::npos) {
-        return body;
-    }
-    
-    std::string headersStr = partStr.substr(0, headersEnd);
-    
-    parsePartHeaders(headersStr, body);
-    
-    size_t dataStart = start + headersEnd + 4;
-    size_t dataEnd = end;
-    
-    if (dataEnd >= 2 && data[dataEnd - 2] == '\r' && data[dataEnd - 1] == '\n') {
-        dataEnd -= 2;
-    }
-    
-    if (dataStart < dataEnd) {
-        size_t dataSize = dataEnd - dataStart;
-        
-        body.setBinaryData(&data[dataStart], dataSize);
-        
-        
-        if (!body.getFileName().empty()) {
-        }
-    }
-    
-    return body;
-}
-
 void RequestParser::parsePartHeaders(const std::string& headersStr, RequestBody& body) {
     std::vector<std::string> headerLines = split(headersStr, "\r\n");
     
@@ -204,7 +107,7 @@ std::string RequestParser::extractBoundary(const std::string& contentType) {
 std::vector<RequestBody> RequestParser::parseUrlEncodedData(const Request& req) {
     std::vector<RequestBody> bodies;
     
-    std::string bodyData = req.getRawBody();
+    std::string bodyData = req.getRawBody().str();
     std::vector<std::string> pairs = split(bodyData, "&");
     
     for (size_t i = 0; i < pairs.size(); ++i) {
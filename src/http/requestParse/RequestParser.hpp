@@ -14,9 +14,6 @@ public:
     static RequestBody              extractBodyPart(const std::string &rawBodyPart);
     static void                     parseHexa(std::string &hexString);
     static std::vector<RequestBody> ParseBody(const Request &req);
-    static std::vector<RequestBody> parseMultipartFormData(const Request& req, const std::string& contentType);
-    static std::vector<RequestBody> parseMultipartBinary(const std::vector<char>& data, const std::string& boundary);
-    static RequestBody parseMultipartPart(const std::vector<char>& data, size_t start, size_t end);
     static void parsePartHeaders(const std::string& headersStr, RequestBody& body);
     static void parseContentDisposition(const std::string& header, RequestBody& body);
     static void parseContentType(const std::string& header, RequestBody& body);
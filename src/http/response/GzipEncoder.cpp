@@ -0,0 +1,127 @@
+#include "GzipEncoder.hpp"
+#include "Response.hpp"
+#include "../../config/LocationConfig.hpp"
+#include "../httpMethods/utils/ContentEncoding.hpp"
+#include <strings.h>
+
+int GzipEncoder::s_budgetPercent = 50;
+long GzipEncoder::s_windowStart = 0;
+long GzipEncoder::s_spentMicros = 0;
+
+static const long BUDGET_WINDOW_MICROS = 1000000;
+
+GzipEncoder::GzipEncoder() : active(false) {
+    std::memset(&stream, 0, sizeof(stream));
+}
+
+GzipEncoder::~GzipEncoder() {
+    if (active) {
+        deflateEnd(&stream);
+    }
+}
+
+long GzipEncoder::nowMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000L;
+}
+
+void GzipEncoder::charge(long startMicros) {
+    s_spentMicros += nowMicros() - startMicros;
+}
+
+void GzipEncoder::setCpuBudget(int percent) {
+    s_budgetPercent = percent;
+}
+
+bool GzipEncoder::begin(int level) {
+    // windowBits 15 + 16 selects the gzip wrapper instead of raw zlib.
+    active = deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    return active;
+}
+
+// Compresses data onto out. Without finish the output is flushed to a byte
+// boundary, so a streamed response never holds back what it has produced.
+bool GzipEncoder::write(const char* data, size_t size, std::string& out, bool finish) {
+    if (!active) {
+        return false;
+    }
+    long start = nowMicros();
+    char buffer[16384];
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+    stream.avail_in = static_cast<uInt>(size);
+    int flush = finish ? Z_FINISH : Z_SYNC_FLUSH;
+    int result;
+    do {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+        result = deflate(&stream, flush);
+        if (result == Z_STREAM_ERROR) {
+            charge(start);
+            return false;
+        }
+        out.append(buffer, sizeof(buffer) - stream.avail_out);
+    } while (stream.avail_out == 0 || (finish && result != Z_STREAM_END));
+    charge(start);
+    return true;
+}
+
+bool GzipEncoder::compress(const char* data, size_t size, int level, std::string& out) {
+    GzipEncoder encoder;
+    if (!encoder.begin(level)) {
+        return false;
+    }
+    out.reserve(size / 3);
+    return encoder.write(data, size, out, true);
+}
+
+static bool findHeader(const std::map<std::string, std::string>& headers, const char* name,
+                       std::string& value) {
+    for (std::map<std::string, std::string>::const_iterator it = headers.begin(); it != headers.end(); ++it) {
+        if (strcasecmp(it->first.c_str(), name) == 0) {
+            value = it->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the level to compress response at, or 0 to send it as is. Any
+// response the location would compress for some client gets Vary, so that
+// shared caches keep the two forms apart. Responses that already carry an
+// encoding, a validator (static files) or a byte range are never touched.
+int GzipEncoder::negotiate(unsigned acceptedCodings, const LocationConfig* location,
+                           Response& response, size_t bodySize) {
+    int status = response.getStatus();
+    std::map<std::string, std::string> headers = response.getHeaders();
+    std::string value;
+    if (!location || !location->getGzip() || status < 200 || status == 204 || status == 206
+        || status == 304 || findHeader(headers, "Content-Encoding", value)
+        || findHeader(headers, "ETag", value) || !findHeader(headers, "Content-Type", value)
+        || !location->isGzipType(value)) {
+        return 0;
+    }
+    if (findHeader(headers, "Vary", value)) {
+        response.removeHeader("Vary");
+        response.addHeader("Vary", value + ", Accept-Encoding");
+    } else {
+        response.addHeader("Vary", "Accept-Encoding");
+    }
+    if (!(acceptedCodings & CODING_GZIP) || bodySize < location->getGzipMinLength()) {
+        return 0;
+    }
+    
+    if (s_budgetPercent >= 100) {
+        return location->getGzipCompLevel();
+    }
+    long now = nowMicros();
+    if (now - s_windowStart >= BUDGET_WINDOW_MICROS) {
+        s_windowStart = now;
+        s_spentMicros = 0;
+    }
+    long allowed = BUDGET_WINDOW_MICROS / 100 * s_budgetPercent;
+    if (s_spentMicros >= allowed) {
+        return 0;
+    }
+    return (s_spentMicros >= allowed / 2) ? 1 : location->getGzipCompLevel();
+}
@@ -0,0 +1,45 @@
+#ifndef GZIP_ENCODER_HPP
+#define GZIP_ENCODER_HPP
+
+#include "../../../include/webserv.hpp"
+#include <zlib.h>
+
+class Response;
+class LocationConfig;
+
+// Streaming gzip for responses the server produces itself (listings, POST
+// summaries, CGI output). Static files are left alone; they have their
+// precompressed sidecars.
+// All compression in a worker draws on one CPU budget, gzip_cpu_budget
+// percent of each second: past half of it new responses are compressed at
+// level 1, past all of it not at all, so a saturated worker stops spending
+// time on compression instead of falling further behind.
+class GzipEncoder {
+private:
+    z_stream stream;
+    bool active;
+
+    static int s_budgetPercent;
+    static long s_windowStart;
+    static long s_spentMicros;
+
+    GzipEncoder(const GzipEncoder&);
+    GzipEncoder& operator=(const GzipEncoder&);
+
+    static long nowMicros();
+    static void charge(long startMicros);
+
+public:
+    GzipEncoder();
+    ~GzipEncoder();
+
+    bool begin(int level);
+    bool write(const char* data, size_t size, std::string& out, bool finish);
+
+    static void setCpuBudget(int percent);
+    static int negotiate(unsigned acceptedCodings, const LocationConfig* location,
+                         Response& response, size_t bodySize);
+    static bool compress(const char* data, size_t size, int level, std::string& out);
+};
+
+#endif
@@ -11,4 +11,6 @@ class	HttpMethodDispatcher {
 	public:
 		static Response	*executeHttpMethod(const Request &request, 
                                       const ServerConfig& serverConfig);
+		static const LocationConfig	*findPostLocation(const Request &request,
+                                      const ServerConfig& serverConfig);
 };
@@ -84,24 +84,28 @@ static std::string resolveFilePath(const std::string& uri,
     return fullPath;
 }
 
-static bool isCgiByExtension(const std::string& uri) {
-    std::string uriPath = uri;
-    size_t queryPos = uriPath.find('?');
-    if (queryPos != std::string::npos) {
-        uriPath = uriPath.substr(0, queryPos);
-    }
-    
-    const char* extensions[] = {".py", ".js", NULL};
+// Location whose POSThandler will receive this request, or NULL when it
+// would be answered otherwise (redirect, 405, CGI, 404). Decided from the
+// head alone, so the body can be routed before it arrives.
+const LocationConfig* HttpMethodDispatcher::findPostLocation(const Request &request,
+                                                             const ServerConfig &serverConfig) {
+    std::string uri = request.getURI();
+    const LocationConfig* location = serverConfig.findLocation(uri);
     
-    for (int i = 0; extensions[i] != NULL; ++i) {
-        std::string ext = extensions[i];
-        if (uriPath.length() >= ext.length()) {
-            if (uriPath.substr(uriPath.length() - ext.length()) == ext) {
-                return true;
-            }
+    if (!location || location->hasReturn() || request.getMethod() != "POST"
+        || !location->isMethodAllowed("POST")) {
+        return NULL;
+    }
+    if (location->isCGIEnabled() && CGIhandler::isCgiByExtension(uri)) {
+        return NULL;
+    }
+    if (!isUploadEndpoint(uri, location) && hasFileExtension(uri)) {
+        std::string filePath = resolveFilePath(uri, location, serverConfig);
+        if (!fileExists(filePath) && !isDirectory(filePath)) {
+            return NULL;
         }
     }
-    return false;
+    return location;
 }
 
 Response* HttpMethodDispatcher::executeHttpMethod(const Request &request, 
@@ -164,7 +168,7 @@ Response* HttpMethodDispatcher::executeHttpMethod(const Request &request,
 
     if (location->isCGIEnabled())
     {
-        if (isCgiByExtension(uri))
+        if (CGIhandler::isCgiByExtension(uri))
         {
             HttpMethodHandler *handler = new CGIhandler();
             Response *output = handler->handler(request, location, &serverConfig);
@@ -172,6 +176,12 @@ Response* HttpMethodDispatcher::executeHttpMethod(const Request &request,
             return output;
         }
     }
+    if (method == "GET") {
+        Response* cached = GEThandler::serveCached(request, location);
+        if (cached) {
+            return cached;
+        }
+    }
     std::string filePath = resolveFilePath(uri, location, serverConfig);
     bool resourceExists = fileExists(filePath) || isDirectory(filePath);
     
@@ -6,6 +6,8 @@
 #include <fstream>
 #include <sstream>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <strings.h>
 
 static const std::map<int, std::string> initExitCodes() {
     std::map<int, std::string> output;
@@ -13,6 +15,7 @@ static const std::map<int, std::string> initExitCodes() {
     output[200] = "OK";
     output[201] = "Created";
     output[204] = "No Content";
+    output[206] = "Partial Content";
     
     output[301] = "Moved Permanently";
     output[302] = "Found";
@@ -30,6 +33,7 @@ static const std::map<int, std::string> initExitCodes() {
     output[413] = "Request Entity Too Large";
     output[414] = "Request-URI Too Long";
     output[415] = "Unsupported Media Type";
+    output[416] = "Range Not Satisfiable";
     
     output[500] = "Internal Server Error";
     output[501] = "Not Implemented";
@@ -157,13 +161,13 @@ Response* Response::makeErrorResponse(int status, const ServerConfig* serverConf
         errorBody += "</body></html>";
     }
     
-    outputResponse->body = errorBody;
+    ss << errorBody.size();
+    outputResponse->body = SharedBuffer::adopt(errorBody);
     
     tmpPair.first = "Content-Type";
     tmpPair.second = "text/html";
     headers.insert(tmpPair);
     
-    ss << errorBody.size();
     tmpPair.first = "Content-Length";
     tmpPair.second = ss.str();
     headers.insert(tmpPair);
@@ -173,6 +177,10 @@ Response* Response::makeErrorResponse(int status, const ServerConfig* serverConf
     return outputResponse;
 }
 
+Response::Response() : status(200) {}
+
+Response::~Response() {}
+
 void	Response::setStatus(int statusCode) {
 	this->status = statusCode;
 }
@@ -190,7 +198,40 @@ void	Response::setVersion(const std::string &version) {
 }
 
 void	Response::setBody(const std::string &rawBody) {
-	this->body = rawBody;
+	this->body = SharedBuffer(rawBody);
+}
+
+void	Response::setBody(const SharedBuffer &sharedBody) {
+	this->body = sharedBody;
+}
+
+// Takes ownership of fd.
+void	Response::setBodyFile(int fd, off_t offset, size_t length) {
+	bodyParts.clear();
+	this->body = SharedBuffer();
+	addBodyFilePart(SharedFile(fd), offset, length);
+}
+
+void	Response::addBodyPart(const SharedBuffer &buffer, size_t offset, size_t length) {
+	ResponseBodyPart part;
+
+	part.buffer = buffer;
+	part.offset = offset;
+	part.length = length;
+	bodyParts.push_back(part);
+}
+
+void	Response::addBodyPart(const std::string &text) {
+	addBodyPart(SharedBuffer(text), 0, text.size());
+}
+
+void	Response::addBodyFilePart(const SharedFile &file, off_t offset, size_t length) {
+	ResponseBodyPart part;
+
+	part.file = file;
+	part.offset = offset;
+	part.length = length;
+	bodyParts.push_back(part);
 }
 
 void	Response::setDate() {
@@ -207,16 +248,52 @@ void	Response::setServer(const std::string &srv) {
 	this->server = srv;
 }
 
+void	Response::setCacheFilePath(const std::string &path) {
+	this->cacheFilePath = path;
+}
+
 void Response::addHeader(const std::string &key, const std::string &value)
 {
 	headers[key] = value;
 }
 
+// Case-insensitive, as CGI scripts name their headers as they like.
+void	Response::removeHeader(const std::string &key) {
+	std::map<std::string, std::string>::iterator it = headers.begin();
+	while (it != headers.end()) {
+		if (strcasecmp(it->first.c_str(), key.c_str()) == 0)
+			headers.erase(it++);
+		else
+			++it;
+	}
+}
+
 
 int	Response::getStatus() const {
 	return (status);
 }
 
+std::string	Response::getCacheFilePath() const {
+	return (cacheFilePath);
+}
+
+size_t	Response::getBodyPartCount() const {
+	return (bodyParts.size());
+}
+
+const ResponseBodyPart&	Response::getBodyPart(size_t index) const {
+	return (bodyParts[index]);
+}
+
+size_t	Response::getContentSize() const {
+	if (bodyParts.empty())
+		return (body.size());
+	size_t size = 0;
+	for (size_t i = 0; i < bodyParts.size(); ++i)
+		size += bodyParts[i].length;
+	return (size);
+}
+
 std::string	Response::getConnection() const {
 	return (connection);
 }
@@ -230,6 +307,10 @@ std::string	Response::getVersion() const {
 }
 
 std::string	Response::getBody() const {
+	return (body.str());
+}
+
+const SharedBuffer&	Response::getBodyBuffer() const {
 	return (body);
 }
 
@@ -241,26 +322,35 @@ std::string Response::getDate() const {
 	return (date);
 }
 
-std::string	Response::toString() const {
-	std::stringstream stream;
+// Everything from the status code through the Date header; the version in
+// front and the Connection header after it are left to serializeHead().
+std::string	Response::serializeHeadFields() const {
+	std::string head;
 
-	stream << version << " " << status << " ";
+	head.reserve(256);
+	head += " " + ParseUtils::toString(status) + " ";
 	std::map<int, std::string>::const_iterator exitIt = EXIT_CODES.find(status);
-	if (exitIt != EXIT_CODES.end())
-    	stream << exitIt->second << "\r\n";
-	else
-    	stream << "Unknown Status Code\r\n";
+	head += (exitIt != EXIT_CODES.end()) ? exitIt->second : "Unknown Status Code";
+	head += "\r\n";
 	std::map<std::string, std::string>::const_iterator headersIter = headers.begin();
 	for (; headersIter != headers.end(); headersIter++)
-		stream << headersIter->first << ": " << headersIter->second << "\r\n";
+		head += headersIter->first + ": " + headersIter->second + "\r\n";
 	if (!server.empty())
-		stream << "Server: " << server << "\r\n";
+		head += "Server: " + server + "\r\n";
 	if (!date.empty())
-		stream << "Date: " << date << "\r\n";
+		head += "Date: " + date + "\r\n";
+	return (head);
+}
+
+std::string	Response::serializeHead() const {
+	std::string head = version + serializeHeadFields();
+
 	if (!connection.empty())
-		stream << "Connection: " << connection << "\r\n";
-	stream << "\r\n";
-	if (!body.empty())
-		stream << body;
-	return (stream.str());
-}
\ No newline at end of file
+		head += "Connection: " + connection + "\r\n";
+	head += "\r\n";
+	return (head);
+}
+
+std::string	Response::toString() const {
+	return (serializeHead() + body.str());
+}
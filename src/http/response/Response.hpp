@@ -2,38 +2,77 @@
 
 #include "../../../include/webserv.hpp"
 #include "../requestParse/Request.hpp"
+#include "SharedBuffer.hpp"
+#include "SharedFile.hpp"
 
 class ServerConfig;
 
+// One piece of a body assembled from parts: bytes [offset, offset + length)
+// of either buffer or, when file is open, an open file.
+struct	ResponseBodyPart {
+	SharedBuffer	buffer;
+	SharedFile		file;
+	off_t			offset;
+	size_t			length;
+
+	ResponseBodyPart() : offset(0), length(0) {}
+};
+
+// The body is either a shared in-memory buffer or a list of parts, which
+// lets static files (sent with sendfile()) and byte ranges of cached files
+// go out without being copied. File parts share their descriptor with the
+// output queue, which closes it after the last part is sent. The head is serialized separately
+// so the body never has to be copied behind it.
 class	Response {
 	private:
 		static const std::map<int, std::string> EXIT_CODES;
 		std::map<std::string, std::string> 	headers;
 		std::string							connection;
 		std::string							version;
-		std::string							body;
+		SharedBuffer						body;
 		std::string							server;
 		std::string							date;
 		int									status;
+		std::vector<ResponseBodyPart>		bodyParts;
+		std::string							cacheFilePath;
+
+		Response(const Response&);
+		Response& operator=(const Response&);
 
 	public:
+		Response();
+		~Response();
 
 		void	setStatus(int statusCode);
 		void	setConnection(const std::string &connection);
 		void	setHeaders(const std::map<std::string, std::string> &headers);
 		void	setVersion(const std::string &versiom);
 		void	setBody(const std::string &rawBody);
+		void	setBody(const SharedBuffer &sharedBody);
+		void	setBodyFile(int fd, off_t offset, size_t length);
+		void	addBodyPart(const SharedBuffer &buffer, size_t offset, size_t length);
+		void	addBodyPart(const std::string &text);
+		void	addBodyFilePart(const SharedFile &file, off_t offset, size_t length);
 		void	setServer(const std::string &srv);
 		void	setDate();
 		void 	addHeader(const std::string &key, const std::string &value);
+		void	removeHeader(const std::string &key);
+		void	setCacheFilePath(const std::string &path);
 
 		std::map<std::string, std::string>	getHeaders() const;
 		std::string							getConnection() const;
 		std::string							getVersion() const;
 		std::string							getBody() const;
+		const SharedBuffer&					getBodyBuffer() const;
 		std::string							getServer() const;
 		std::string							getDate() const;
 		int									getStatus() const;
+		size_t								getBodyPartCount() const;
+		const ResponseBodyPart&				getBodyPart(size_t index) const;
+		size_t								getContentSize() const;
+		std::string							getCacheFilePath() const;
+		std::string 						serializeHeadFields() const;
+		std::string 						serializeHead() const;
 		std::string 						toString() const;
 
 		static Response *makeErrorResponse(int status, const ServerConfig* serverConfig = NULL); 
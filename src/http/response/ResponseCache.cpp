@@ -0,0 +1,110 @@
+#include "ResponseCache.hpp"
+#include "../httpMethods/utils/FileCache.hpp"
+#include <ctime>
+
+std::map<ResponseCache::Key, ResponseCache::Entry> ResponseCache::s_entries;
+std::list<ResponseCache::Key> ResponseCache::s_lru;
+size_t ResponseCache::s_bytes = 0;
+size_t ResponseCache::s_maxBytes = 0;
+unsigned long ResponseCache::s_hits = 0;
+unsigned long ResponseCache::s_misses = 0;
+
+static const size_t HTTP_DATE_LENGTH = 29;
+
+void ResponseCache::configure(size_t maxBytes) {
+    s_maxBytes = maxBytes;
+    while (!s_lru.empty() && s_bytes > s_maxBytes) {
+        erase(s_entries.find(s_lru.back()));
+    }
+}
+
+// The body is counted even though FileCache usually holds the same buffer:
+// an entry keeps it alive after FileCache has let go of it.
+size_t ResponseCache::entryCost(const Key& key, const Entry& entry) {
+    return sizeof(Entry) + key.second.size() + entry.head.size()
+        + entry.filePath.size() + entry.body.size();
+}
+
+void ResponseCache::erase(std::map<Key, Entry>::iterator it) {
+    s_bytes -= entryCost(it->first, it->second);
+    s_lru.erase(it->second.lruPosition);
+    s_entries.erase(it);
+}
+
+const ResponseCache::Entry* ResponseCache::lookup(const void* server, const std::string& uri) {
+    if (s_maxBytes == 0) {
+        return NULL;
+    }
+    std::map<Key, Entry>::iterator it = s_entries.find(Key(server, uri));
+    if (it == s_entries.end()) {
+        ++s_misses;
+        return NULL;
+    }
+    
+    Entry& entry = it->second;
+    CachedFile file;
+    if (!FileCache::lookup(entry.filePath, file) || file.content.data() != entry.body.data()) {
+        erase(it);
+        ++s_misses;
+        return NULL;
+    }
+    
+    time_t now = std::time(NULL);
+    if (entry.dateSecond != now) {
+        char date[64];
+        std::tm* gmt = std::gmtime(&now);
+        if (gmt && std::strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", gmt) == HTTP_DATE_LENGTH) {
+            entry.head.replace(entry.dateOffset, HTTP_DATE_LENGTH, date, HTTP_DATE_LENGTH);
+            entry.dateSecond = now;
+        }
+    }
+    s_lru.splice(s_lru.begin(), s_lru, entry.lruPosition);
+    ++s_hits;
+    return &entry;
+}
+
+void ResponseCache::store(const void* server, const std::string& uri, const std::string& head,
+                          const SharedBuffer& body, const std::string& filePath) {
+    size_t dateOffset = head.find("\r\nDate: ");
+    if (s_maxBytes == 0 || dateOffset == std::string::npos
+        || head.size() < dateOffset + 8 + HTTP_DATE_LENGTH) {
+        return;
+    }
+    
+    Key key(server, uri);
+    std::map<Key, Entry>::iterator existing = s_entries.find(key);
+    if (existing != s_entries.end()) {
+        erase(existing);
+    }
+    
+    Entry entry;
+    entry.head = head;
+    entry.dateOffset = dateOffset + 8;
+    entry.dateSecond = std::time(NULL);
+    entry.body = body;
+    entry.filePath = filePath;
+    size_t cost = entryCost(key, entry);
+    if (cost > s_maxBytes / 4) {
+        return;
+    }
+    while (!s_lru.empty() && s_bytes + cost > s_maxBytes) {
+        erase(s_entries.find(s_lru.back()));
+    }
+    
+    s_lru.push_front(key);
+    Entry& stored = s_entries[key];
+    stored = entry;
+    stored.lruPosition = s_lru.begin();
+    s_bytes += cost;
+}
+
+void ResponseCache::reportStats() {
+    if (s_maxBytes == 0) {
+        return;
+    }
+    std::cout << "[STATS] response cache hits=" << s_hits << " misses=" << s_misses
+              << " entries=" << s_entries.size() << " bytes=" << s_bytes
+              << "/" << s_maxBytes << std::endl;
+    s_hits = 0;
+    s_misses = 0;
+}
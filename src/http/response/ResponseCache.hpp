@@ -0,0 +1,50 @@
+#ifndef RESPONSE_CACHE_HPP
+#define RESPONSE_CACHE_HPP
+
+#include "../../../include/webserv.hpp"
+#include "SharedBuffer.hpp"
+#include <list>
+
+// Per-worker cache of complete GET responses for files held by FileCache.
+// An entry keeps the serialized head from the status code up to the Date
+// header, and the body buffer it shares with FileCache. A hit is
+// served by copying that head (with Date patched at most once per second)
+// and queueing the body, without building a Response.
+// Only the status line's version and the Connection header differ per
+// request; the client adds those. Entries stay valid only while FileCache
+// still returns the same body buffer for their file, so they follow its
+// revalidation.
+class ResponseCache {
+public:
+    struct Entry {
+        std::string head;
+        size_t dateOffset;
+        time_t dateSecond;
+        SharedBuffer body;
+        std::string filePath;
+        std::list<std::pair<const void*, std::string> >::iterator lruPosition;
+    };
+
+private:
+    typedef std::pair<const void*, std::string> Key;
+
+    static std::map<Key, Entry> s_entries;
+    static std::list<Key> s_lru;
+    static size_t s_bytes;
+    static size_t s_maxBytes;
+    static unsigned long s_hits;
+    static unsigned long s_misses;
+
+    static size_t entryCost(const Key& key, const Entry& entry);
+    static void erase(std::map<Key, Entry>::iterator it);
+
+public:
+    static void configure(size_t maxBytes);
+    static bool enabled() { return s_maxBytes > 0; }
+    static const Entry* lookup(const void* server, const std::string& uri);
+    static void store(const void* server, const std::string& uri, const std::string& head,
+                      const SharedBuffer& body, const std::string& filePath);
+    static void reportStats();
+};
+
+#endif
@@ -0,0 +1,55 @@
+#include "SharedBuffer.hpp"
+
+SharedBuffer::SharedBuffer() : block(NULL) {}
+
+SharedBuffer::SharedBuffer(const std::string& data) : block(NULL) {
+    if (!data.empty()) {
+        block = new Block();
+        block->data = data;
+        block->refs = 1;
+    }
+}
+
+SharedBuffer::SharedBuffer(const SharedBuffer& other) : block(other.block) {
+    if (block) {
+        ++block->refs;
+    }
+}
+
+SharedBuffer& SharedBuffer::operator=(const SharedBuffer& other) {
+    if (block != other.block) {
+        release();
+        block = other.block;
+        if (block) {
+            ++block->refs;
+        }
+    }
+    return *this;
+}
+
+SharedBuffer::~SharedBuffer() {
+    release();
+}
+
+void SharedBuffer::release() {
+    if (block && --block->refs == 0) {
+        delete block;
+    }
+    block = NULL;
+}
+
+// Takes the contents of data without copying them; data is left empty.
+SharedBuffer SharedBuffer::adopt(std::string& data) {
+    SharedBuffer buffer;
+    if (!data.empty()) {
+        buffer.block = new Block();
+        buffer.block->data.swap(data);
+        buffer.block->refs = 1;
+    }
+    return buffer;
+}
+
+const std::string& SharedBuffer::str() const {
+    static const std::string empty;
+    return block ? block->data : empty;
+}
@@ -0,0 +1,35 @@
+#ifndef SHARED_BUFFER_HPP
+#define SHARED_BUFFER_HPP
+
+#include "../../../include/webserv.hpp"
+
+// Immutable, reference-counted byte buffer. Copies share one allocation, so
+// a body can be handed to the output queue, or kept in a cache and sent to
+// many clients, without copying its bytes. Each worker is single-threaded,
+// so the count is a plain integer.
+class SharedBuffer {
+private:
+    struct Block {
+        std::string data;
+        size_t refs;
+    };
+    Block* block;
+
+    void release();
+
+public:
+    SharedBuffer();
+    explicit SharedBuffer(const std::string& data);
+    SharedBuffer(const SharedBuffer& other);
+    SharedBuffer& operator=(const SharedBuffer& other);
+    ~SharedBuffer();
+
+    static SharedBuffer adopt(std::string& data);
+
+    const char* data() const { return block ? block->data.data() : ""; }
+    size_t size() const { return block ? block->data.size() : 0; }
+    bool empty() const { return size() == 0; }
+    const std::string& str() const;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include "SharedFile.hpp"
+#include <unistd.h>
+
+SharedFile::SharedFile() : handle(NULL) {}
+
+// Takes ownership of fd.
+SharedFile::SharedFile(int fd) : handle(NULL) {
+    if (fd >= 0) {
+        handle = new Handle();
+        handle->fd = fd;
+        handle->refs = 1;
+    }
+}
+
+SharedFile::SharedFile(const SharedFile& other) : handle(other.handle) {
+    if (handle) {
+        ++handle->refs;
+    }
+}
+
+SharedFile& SharedFile::operator=(const SharedFile& other) {
+    if (handle != other.handle) {
+        release();
+        handle = other.handle;
+        if (handle) {
+            ++handle->refs;
+        }
+    }
+    return *this;
+}
+
+SharedFile::~SharedFile() {
+    release();
+}
+
+void SharedFile::release() {
+    if (handle && --handle->refs == 0) {
+        close(handle->fd);
+        delete handle;
+    }
+    handle = NULL;
+}
@@ -0,0 +1,30 @@
+#ifndef SHARED_FILE_HPP
+#define SHARED_FILE_HPP
+
+#include "../../../include/webserv.hpp"
+
+// Reference-counted open file descriptor, closed when the last copy goes
+// away. Every reader passes its own offset to sendfile()/pread(), so the
+// parts of one response can all be sent from the same descriptor.
+class SharedFile {
+private:
+    struct Handle {
+        int fd;
+        size_t refs;
+    };
+    Handle* handle;
+
+    void release();
+
+public:
+    SharedFile();
+    explicit SharedFile(int fd);
+    SharedFile(const SharedFile& other);
+    SharedFile& operator=(const SharedFile& other);
+    ~SharedFile();
+
+    int fd() const { return handle ? handle->fd : -1; }
+    bool isOpen() const { return handle != NULL; }
+};
+
+#endif
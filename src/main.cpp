@@ -2,6 +2,7 @@
 #include "../src/config/ConfigParser.hpp"
 #include "../src/server/Server.hpp"
 #include "../src/server/EventManager.hpp"
+#include "../src/server/WorkerPool.hpp"
 
 int main(int argc, char* argv[], char* envp[]) {
     try {
@@ -33,11 +34,8 @@ int main(int argc, char* argv[], char* envp[]) {
             }
         }
 
-        EventManager event_mgr(100);
-        Server server(configs, envMap);
-
-        server.initialize(event_mgr);
-        server.run(event_mgr);
+        WorkerPool workers(configs, envMap, WSconfig.getGlobalConfig());
+        return workers.run();
     } 
     catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
@@ -3,7 +3,9 @@
 #include "../client/Client.hpp"
 #include "../../include/webserv.hpp"
 
-EventManager::EventManager(int max_events) : epoll_fd(-1), events(NULL), max_events(max_events)
+EventManager::EventManager(int max_events) : epoll_fd(-1), events(NULL), max_events(max_events),
+    edge_triggered(false), io_budget(256 * 1024), full_wakeups(0),
+    stats_interval(0)
 {
     epoll_fd = epoll_create(max_events);
     if (epoll_fd == -1) {
@@ -11,6 +13,12 @@ EventManager::EventManager(int max_events) : epoll_fd(-1), events(NULL), max_eve
     }
     events = new epoll_event[max_events];
     std::memset(events, 0, sizeof(epoll_event) * max_events);
+
+    size_t buckets = 1;
+    while ((1 << (buckets - 1)) <= max_events) {
+        ++buckets;
+    }
+    wakeup_histogram.assign(buckets, 0);
 }
 
 EventManager::~EventManager()
@@ -25,11 +33,14 @@ EventManager::~EventManager()
     }
 }
 
-void EventManager::addSocket(int fd, void* data, uint32_t event_flags) {
+void EventManager::addSocket(int fd, EventSource* source, uint32_t event_flags) {
     epoll_event event;
     memset(&event, 0, sizeof(event));
     event.events = event_flags;
-    event.data.ptr = data;
+    event.data.ptr = source;
+    if (edge_triggered && source->eventType != EVENT_LISTENER) {
+        event.events |= EPOLLET;
+    }
     
     if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == -1) {
         throw std::runtime_error("Failed to add socket to epoll");
@@ -46,13 +57,15 @@ void EventManager::removeSocket(int fd) {
     }
 }
 
-void EventManager::modifySocket(int fd, void* data, uint32_t event_flags)
+void EventManager::modifySocket(int fd, EventSource* source, uint32_t event_flags)
 {
     epoll_event event;
     std::memset(&event, 0, sizeof(event));
     event.events = event_flags;
-    event.data.ptr = data;
-    
+    event.data.ptr = source;
+    if (edge_triggered && source->eventType != EVENT_LISTENER) {
+        event.events |= EPOLLET;
+    }
     
     if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) == -1) {
         std::cerr << "[ERROR] Failed to modify socket " << fd << " in epoll: " 
@@ -62,9 +75,48 @@ void EventManager::modifySocket(int fd, void* data, uint32_t event_flags)
     
 }
 
-int EventManager::waitForEvents(epoll_event* event_buffer, int timeout)
+int EventManager::waitForEvents(int timeout)
 {
-    int result = epoll_wait(epoll_fd, event_buffer, max_events, timeout);
+    int result = epoll_wait(epoll_fd, events, max_events, timeout);
     
+    if (result >= 0) {
+        recordWakeup(result);
+    }
     return result;
+}
+
+void EventManager::recordWakeup(int count)
+{
+    size_t bucket = 0;
+    while (count >> bucket) {
+        ++bucket;
+    }
+    ++wakeup_histogram[bucket];
+    if (count == max_events) {
+        ++full_wakeups;
+    }
+}
+
+void EventManager::reportStats()
+{
+    unsigned long total = 0;
+    std::ostringstream buckets;
+
+    for (size_t i = 0; i < wakeup_histogram.size(); ++i) {
+        total += wakeup_histogram[i];
+        if (wakeup_histogram[i] == 0) {
+            continue;
+        }
+        if (i < 2) {
+            buckets << " " << i;
+        } else {
+            buckets << " " << (1 << (i - 1)) << "-" << std::min((1 << i) - 1, max_events);
+        }
+        buckets << ":" << wakeup_histogram[i];
+    }
+    std::cout << "[STATS] epoll wakeups=" << total << " full=" << full_wakeups
+              << " batch=" << max_events << " events/wakeup" << buckets.str() << std::endl;
+
+    wakeup_histogram.assign(wakeup_histogram.size(), 0);
+    full_wakeups = 0;
 }
\ No newline at end of file
@@ -2,19 +2,41 @@
 #define EVENT_MANAGER_HPP
 
 #include "../../include/webserv.hpp"
+#include "EventSource.hpp"
+#include "TimerWheel.hpp"
 
 class EventManager {
 private:
     int epoll_fd;
     epoll_event* events;
     int max_events;
+    bool edge_triggered;
+    size_t io_budget;
+    // wakeup_histogram[0] counts timeouts, bucket b > 0 counts wakeups that
+    // returned between 2^(b-1) and 2^b - 1 events.
+    std::vector<unsigned long> wakeup_histogram;
+    unsigned long full_wakeups;
+    int stats_interval;
+    TimerWheel timers;
+
+    void recordWakeup(int count);
 public:
     EventManager(int max_events = 100);
     ~EventManager();
-    void addSocket(int fd, void* data, uint32_t event_flags);
+    void addSocket(int fd, EventSource* source, uint32_t event_flags);
     void removeSocket(int fd);
-    void modifySocket(int fd, void* data, uint32_t events);
-    int waitForEvents(epoll_event* event_buffer, int timeout);
+    void modifySocket(int fd, EventSource* source, uint32_t events);
+    int waitForEvents(int timeout);
+    const epoll_event& getEvent(int index) const { return events[index]; }
+    int getMaxEvents() const { return max_events; }
+    void setStatsInterval(int seconds) { stats_interval = seconds; }
+    int getStatsInterval() const { return stats_interval; }
+    void reportStats();
+    TimerWheel& getTimers() { return timers; }
+    void setEdgeTriggered(bool enabled) { edge_triggered = enabled; }
+    bool isEdgeTriggered() const { return edge_triggered; }
+    void setIoBudget(size_t bytes) { io_budget = bytes; }
+    size_t getIoBudget() const { return io_budget; }
 };
 
 #endif
@@ -0,0 +1,35 @@
+#ifndef EVENT_SOURCE_HPP
+#define EVENT_SOURCE_HPP
+
+#include <cstddef>
+
+enum EventSourceType {
+    EVENT_LISTENER,
+    EVENT_CLIENT,
+    EVENT_CGI,
+    EVENT_STATS
+};
+
+struct EventSource;
+
+// Intrusive list node linking an EventSource into a TimerWheel slot.
+struct TimerEntry {
+    long deadline;
+    long tick;
+    EventSource* prev;
+    EventSource* next;
+    bool armed;
+
+    TimerEntry() : deadline(0), tick(0), prev(NULL), next(NULL), armed(false) {}
+};
+
+// Common header of every object registered with EventManager, so that
+// Server::run can dispatch an epoll event or an expired timer on its tag alone.
+struct EventSource {
+    EventSourceType eventType;
+    TimerEntry timer;
+
+    explicit EventSource(EventSourceType type) : eventType(type) {}
+};
+
+#endif
@@ -2,15 +2,18 @@
 #include "./EventManager.hpp"
 #include "../client/Client.hpp"
 #include "../http/httpMethods/cgi/CGIhandler.hpp"
+#include "../http/response/ResponseCache.hpp"
 #include "../../include/GlobalUtils.hpp"
 #include "../../include/webserv.hpp"
 
 Server::Server(const std::vector<ServerConfig>& configs,
-       const std::map<std::string, std::string>& env) : configs(configs), running(false) {
+       const std::map<std::string, std::string>& env) : configs(configs), running(false), reuse_port(false),
+       stats_timer(EVENT_STATS) {
     s_envMap = env;
 }
 
 std::map<std::string, std::string> Server::s_envMap;
+const int Server::MAX_ACCEPTS_PER_WAKEUP;
 
 Server::~Server() {
 	shutdown();
@@ -21,9 +24,13 @@ const std::map<std::string, std::string>& Server::getEnv() {
 }
 
 
+void Server::setReusePort(bool enabled) {
+	reuse_port = enabled;
+}
+
 void Server::initialize(EventManager& event_manager) {
 	for (size_t i = 0; i < configs.size(); ++i) {
-		int server_fd = socket(AF_INET, SOCK_STREAM, 0);
+		int server_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
 		if (server_fd == -1) {
 			std::cerr << "[ERROR] Failed to create socket: " << strerror(errno) << std::endl;
 			throw std::runtime_error("Failed to create socket");
@@ -42,6 +49,12 @@ void Server::initialize(EventManager& event_manager) {
 			throw std::runtime_error("Failed to set SO_REUSEADDR");
 		}
 
+		if (reuse_port && setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) == -1) {
+			std::cerr << "[ERROR] Failed to set SO_REUSEPORT: " << strerror(errno) << std::endl;
+			close(server_fd);
+			throw std::runtime_error("Failed to set SO_REUSEPORT");
+		}
+
 		sockaddr_in server_addr;
 		std::memset(&server_addr, 0, sizeof(server_addr));
 		server_addr.sin_family = AF_INET;
@@ -69,104 +82,149 @@ void Server::initialize(EventManager& event_manager) {
 			throw std::runtime_error("Failed to listen on socket");
 		}
 
-		server_fds.push_back(server_fd);
+		Listener* listener = new Listener(server_fd, &configs[i]);
 		try {
-			event_manager.addSocket(server_fd, this, EPOLLIN);
+			event_manager.addSocket(server_fd, listener, EPOLLIN);
 		} catch (const std::exception& e) {
 			std::cerr << "[ERROR] Failed to register server socket in epoll: " << e.what() << std::endl;
 			close(server_fd);
-			server_fds.pop_back();
+			delete listener;
 			throw;
 		}
+		server_fds.push_back(server_fd);
+		listeners.push_back(listener);
 		
 		std::cout << "[INFO] Server listening on " << configs[i].getHost() 
 				  << ":" << configs[i].getPort() << " with fd=" << server_fd << std::endl;
 	}
+	if (event_manager.getStatsInterval() > 0) {
+		event_manager.getTimers().schedule(&stats_timer,
+			TimerWheel::now() + event_manager.getStatsInterval() * 1000L);
+	}
 }
 
 void Server::run(EventManager& event_manager) {
 	running = true;
 	std::cout << "[INFO] Server started, waiting for connections..." << std::endl;
 	
-	epoll_event* events = new epoll_event[100];
-	
 	while (running) {
-        CGIhandler::checkCgiTimeouts(event_manager);
-
-		int nfds = event_manager.waitForEvents(events, 1000);
+		int timeout = event_manager.getTimers().nextTimeout(TimerWheel::now());
+		int nfds = event_manager.waitForEvents(timeout);
 		
-		if (nfds == -1) {
-			continue;
+		for (int i = 0; i < nfds; ++i) {
+			const epoll_event& event = event_manager.getEvent(i);
+			EventSource* source = static_cast<EventSource*>(event.data.ptr);
+
+			switch (source->eventType) {
+				case EVENT_LISTENER:
+					acceptConnections(static_cast<Listener*>(source), event_manager);
+					break;
+				case EVENT_CGI:
+					handleCgiEvent(static_cast<CgiExecution*>(source), event.events, false, event_manager);
+					break;
+				case EVENT_CLIENT:
+					handleClientEvent(static_cast<Client*>(source), event.events, event_manager);
+					break;
+				case EVENT_STATS:
+					break;
+			}
 		}
-		
-for (int i = 0; i < nfds; ++i)
-{
-    epoll_event& event = events[i];
-
-    if (event.data.ptr == this) 
-    {
-        for (size_t j = 0; j < server_fds.size(); ++j) {
-            if (event.events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
-                acceptConnection(server_fds[j], event_manager);
-            }
-        }
-    }
-    else
-    {
-        bool isCgiEvent = false;
-        
-        for (std::map<int, CgiExecution*>::iterator it = CGIhandler::s_cgiExecutions.begin();
-             it != CGIhandler::s_cgiExecutions.end(); ++it) {
-            if (it->second == event.data.ptr) {
-                CGIhandler::handleCgiEvent(it->first, event.events, event_manager);
-                isCgiEvent = true;
-                break;
-            }
-        }
-        
-        if (!isCgiEvent) {
-            Client* client = static_cast<Client*>(event.data.ptr);
-            
-            if (!client) {
-                std::cerr << "[ERROR] Null client pointer in event" << std::endl;
-                continue;
-            }
-            
-            bool client_valid = false;
-            for (size_t j = 0; j < clients.size(); ++j) {
-                if (clients[j] == client) {
-                    client_valid = true;
-                    break;
-                }
-            }
-            
-            if (!client_valid) {
-                continue;
-            }
-            
-            if (event.events & (EPOLLHUP | EPOLLERR))
-            {
-                client->closeConnection(event_manager);
-                clients.erase(std::remove(clients.begin(), clients.end(), client), clients.end());
-                delete client;
-            }
-            else if (event.events & EPOLLIN)
-            {
-                client->handleRead(event_manager);
-            }
-            else if (event.events & EPOLLOUT)
-            {
-                if (client->isWaitingForCgi()) {
-                    continue;
-                }
-                client->handleWrite(event_manager);
-            }
-        }
-    }
+
+		expireTimers(event_manager);
+		releaseClosedClients();
+		CGIhandler::releaseRetiredExecutions();
+	}
+}
+
+void Server::handleClientEvent(Client* client, uint32_t events, EventManager& event_manager) {
+	if (client->isClosed()) {
+		return;
+	}
+
+	if (events & (EPOLLHUP | EPOLLERR)) {
+		client->closeConnection(event_manager);
+	} else if (events & EPOLLIN) {
+		client->handleRead(event_manager);
+	} else if (events & EPOLLOUT) {
+		client->handleWrite(event_manager);
+	}
+
+	if (client->isClosed()) {
+		removeClient(client);
+		closed_clients.push_back(client);
+	}
+}
+
+// Finishing a CGI response may close its client (a non keep-alive response
+// with nothing left to send), which then has to be released here just as
+// after a client event.
+void Server::handleCgiEvent(CgiExecution* exec, uint32_t events, bool timedOut, EventManager& event_manager) {
+	Client* client = exec->client;
+	bool wasOpen = client && !client->isClosed();
+
+	if (timedOut) {
+		CGIhandler::handleCgiTimeout(exec, event_manager);
+	} else {
+		CGIhandler::handleCgiEvent(exec, events, event_manager);
+	}
+
+	if (wasOpen && client->isClosed()) {
+		removeClient(client);
+		closed_clients.push_back(client);
+	}
 }
+
+void Server::removeClient(Client* client) {
+	size_t index = client->getServerIndex();
+	Client* last = clients.back();
+
+	clients[index] = last;
+	last->setServerIndex(index);
+	clients.pop_back();
+}
+
+void Server::releaseClosedClients() {
+	for (size_t i = 0; i < closed_clients.size(); ++i) {
+		delete closed_clients[i];
 	}
-	
-	delete[] events;
+	closed_clients.clear();
+}
+
+void Server::expireTimers(EventManager& event_manager) {
+	std::vector<EventSource*> expired;
+	event_manager.getTimers().expire(TimerWheel::now(), expired);
+
+	for (size_t i = 0; i < expired.size(); ++i) {
+		switch (expired[i]->eventType) {
+			case EVENT_CLIENT: {
+				Client* client = static_cast<Client*>(expired[i]);
+				if (client->isClosed()) {
+					break;
+				}
+				client->handleTimeout(event_manager);
+				if (client->isClosed()) {
+					removeClient(client);
+					closed_clients.push_back(client);
+				}
+				break;
+			}
+			case EVENT_CGI:
+				handleCgiEvent(static_cast<CgiExecution*>(expired[i]), 0, true, event_manager);
+				break;
+			case EVENT_STATS:
+				reportStats(event_manager);
+				break;
+			case EVENT_LISTENER:
+				break;
+		}
+	}
+}
+
+void Server::reportStats(EventManager& event_manager) {
+	event_manager.reportStats();
+	ResponseCache::reportStats();
+	event_manager.getTimers().schedule(&stats_timer,
+		TimerWheel::now() + event_manager.getStatsInterval() * 1000L);
 }
 
 void Server::shutdown() {
@@ -176,63 +234,57 @@ void Server::shutdown() {
 		delete clients[i];
 	}
 	clients.clear();
+	releaseClosedClients();
 	
 	for (size_t i = 0; i < server_fds.size(); ++i) {
 		close(server_fds[i]);
 	}
 	server_fds.clear();
+	for (size_t i = 0; i < listeners.size(); ++i) {
+		delete listeners[i];
+	}
+	listeners.clear();
 }
 
-void Server::acceptConnection(int server_fd, EventManager& event_manager)
+void Server::acceptConnections(Listener* listener, EventManager& event_manager)
 {
-	sockaddr_in client_addr;
-	socklen_t client_len = sizeof(client_addr);
-	
-	int client_fd = accept(server_fd, (sockaddr*)&client_addr, &client_len);
-	if (client_fd == -1) {
-		return;
-	}
-	
-	if (!setToNonBlocking(client_fd)) {
-		std::cerr << "[ERROR] Failed to set client socket to non-blocking: " << strerror(errno) << std::endl;
-		close(client_fd);
-		return;
-	}
-	
-	ServerConfig* config = NULL;
-	for (size_t i = 0; i < server_fds.size(); ++i) {
-		if (server_fds[i] == server_fd) {
-			config = &configs[i];
-			break;
+	for (int accepted = 0; accepted < MAX_ACCEPTS_PER_WAKEUP; ++accepted) {
+		sockaddr_in client_addr;
+		socklen_t client_len = sizeof(client_addr);
+		
+		int client_fd = accept4(listener->fd, (sockaddr*)&client_addr, &client_len,
+		                        SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (client_fd == -1) {
+			if (errno == EINTR || errno == ECONNABORTED) {
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				std::cerr << "[ERROR] Failed to accept connection: " << strerror(errno) << std::endl;
+			}
+			return;
 		}
-	}
-	
-	if (!config) {
-		std::cerr << "[ERROR] Could not find server config for accepted connection" << std::endl;
-		close(client_fd);
-		return;
-	}
-	
-	Client* client = new Client(client_fd, config);
-	client->setEventManager(&event_manager);
-	clients.push_back(client);
-
-	try {
-		event_manager.addSocket(client_fd, client, EPOLLIN | EPOLLERR | EPOLLHUP);
-	} catch (const std::exception& e) {
-		std::cerr << "[ERROR] Failed to register client socket in epoll: " << e.what() << std::endl;
-		clients.erase(std::remove(clients.begin(), clients.end(), client), clients.end());
-		delete client;
-		close(client_fd);
-		return;
-	}
+		
+		Client* client = new Client(client_fd, listener->config);
+		client->setEventManager(&event_manager);
+		client->updateTimer();
 
-	
-	char client_ip[INET_ADDRSTRLEN];
-	inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
-	std::cout << "[INFO] New connection from " << client_ip 
-			  << ":" << ntohs(client_addr.sin_port) << " on fd=" << client_fd << std::endl;
+		try {
+			event_manager.addSocket(client_fd, client, EPOLLIN | EPOLLERR | EPOLLHUP);
+		} catch (const std::exception& e) {
+			std::cerr << "[ERROR] Failed to register client socket in epoll: " << e.what() << std::endl;
+			delete client;
+			continue;
+		}
+		client->setServerIndex(clients.size());
+		clients.push_back(client);
+
+		char client_ip[INET_ADDRSTRLEN];
+		inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
+		std::cout << "[INFO] New connection from " << client_ip 
+				  << ":" << ntohs(client_addr.sin_port) << " on fd=" << client_fd << std::endl;
+	}
 }
+
 const std::vector<int>& Server::getServerFds() const {
 	return server_fds;
 }
\ No newline at end of file
@@ -4,25 +4,46 @@
 #include "../../include/webserv.hpp"
 #include "../config/ServerConfig.hpp"
 #include "../config/ConfigParser.hpp"
+#include "EventSource.hpp"
 
+struct CgiExecution;
 
+struct Listener : public EventSource {
+    int fd;
+    ServerConfig* config;
+
+    Listener(int fd, ServerConfig* config) : EventSource(EVENT_LISTENER), fd(fd), config(config) {}
+};
 
 class Server {
 private:
     std::vector<int> server_fds;
+    std::vector<Listener*> listeners;
     std::vector<ServerConfig> configs;
     std::vector<Client*> clients;
+    std::vector<Client*> closed_clients;
     bool running;
+    bool reuse_port;
+    // Armed every event_stats_interval seconds, so an idle worker reports too.
+    EventSource stats_timer;
     static std::map<std::string, std::string> s_envMap; 
+    static const int MAX_ACCEPTS_PER_WAKEUP = 128;
 public:
     Server(const std::vector<ServerConfig>& configs,
        const std::map<std::string, std::string>& env);
 
     ~Server();
+    void setReusePort(bool enabled);
     void initialize(EventManager& event_mgr);
     void run(EventManager& event_mgr);
     void shutdown();
-    void acceptConnection(int server_fd, EventManager& event_mgr);
+    void acceptConnections(Listener* listener, EventManager& event_mgr);
+    void expireTimers(EventManager& event_mgr);
+    void handleClientEvent(Client* client, uint32_t events, EventManager& event_mgr);
+    void handleCgiEvent(CgiExecution* exec, uint32_t events, bool timedOut, EventManager& event_mgr);
+    void reportStats(EventManager& event_mgr);
+    void removeClient(Client* client);
+    void releaseClosedClients();
 
     const std::vector<int>& getServerFds() const;
     static const std::map<std::string, std::string>& getEnv();
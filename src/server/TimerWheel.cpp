@@ -0,0 +1,96 @@
+#include "TimerWheel.hpp"
+
+const size_t TimerWheel::SLOT_COUNT;
+const long TimerWheel::TICK_MS;
+
+TimerWheel::TimerWheel() : slots(SLOT_COUNT, static_cast<EventSource*>(NULL)),
+    current_tick(now() / TICK_MS), armed_count(0) {}
+
+long TimerWheel::now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000L;
+}
+
+void TimerWheel::schedule(EventSource* source, long deadline) {
+    if (source->timer.armed) {
+        unlink(source);
+    }
+
+    // Round up so that every entry found in a processed slot is already due.
+    long tick = (deadline + TICK_MS - 1) / TICK_MS;
+    if (tick <= current_tick) {
+        tick = current_tick + 1;
+    }
+
+    EventSource*& head = slots[tick % SLOT_COUNT];
+    source->timer.deadline = deadline;
+    source->timer.tick = tick;
+    source->timer.prev = NULL;
+    source->timer.next = head;
+    if (head) {
+        head->timer.prev = source;
+    }
+    head = source;
+    source->timer.armed = true;
+    ++armed_count;
+}
+
+void TimerWheel::cancel(EventSource* source) {
+    if (source->timer.armed) {
+        unlink(source);
+    }
+}
+
+void TimerWheel::unlink(EventSource* source) {
+    TimerEntry& entry = source->timer;
+
+    if (entry.prev) {
+        entry.prev->timer.next = entry.next;
+    } else {
+        slots[entry.tick % SLOT_COUNT] = entry.next;
+    }
+    if (entry.next) {
+        entry.next->timer.prev = entry.prev;
+    }
+    entry.prev = NULL;
+    entry.next = NULL;
+    entry.armed = false;
+    --armed_count;
+}
+
+// Milliseconds until the next occupied slot is due, or -1 when nothing is
+// armed. A slot may only hold later rounds, which costs one early wakeup.
+int TimerWheel::nextTimeout(long now) const {
+    if (armed_count == 0) {
+        return -1;
+    }
+    for (size_t distance = 1; distance <= SLOT_COUNT; ++distance) {
+        long tick = current_tick + static_cast<long>(distance);
+        if (slots[tick % SLOT_COUNT]) {
+            long wait = tick * TICK_MS - now;
+            return wait > 0 ? static_cast<int>(wait) : 0;
+        }
+    }
+    return 0;
+}
+
+void TimerWheel::expire(long now, std::vector<EventSource*>& expired) {
+    long target = now / TICK_MS;
+    if (target - current_tick > static_cast<long>(SLOT_COUNT)) {
+        current_tick = target - static_cast<long>(SLOT_COUNT);
+    }
+
+    while (current_tick < target) {
+        ++current_tick;
+        EventSource* source = slots[current_tick % SLOT_COUNT];
+        while (source) {
+            EventSource* next = source->timer.next;
+            if (source->timer.tick <= current_tick) {
+                unlink(source);
+                expired.push_back(source);
+            }
+            source = next;
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include "../../include/webserv.hpp"
+#include "EventSource.hpp"
+
+// Hashed timing wheel with TICK_MS resolution. Deadlines further away than
+// one revolution stay in their slot and are skipped until their round comes,
+// so scheduling and cancelling are O(1) whatever the timeout.
+class TimerWheel {
+private:
+    static const size_t SLOT_COUNT = 512;
+    static const long TICK_MS = 100;
+
+    std::vector<EventSource*> slots;
+    long current_tick;
+    size_t armed_count;
+
+    void unlink(EventSource* source);
+public:
+    TimerWheel();
+
+    static long now();
+
+    void schedule(EventSource* source, long deadline);
+    void cancel(EventSource* source);
+    int nextTimeout(long now) const;
+    void expire(long now, std::vector<EventSource*>& expired);
+    size_t size() const { return armed_count; }
+};
+
+#endif
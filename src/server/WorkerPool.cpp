@@ -0,0 +1,158 @@
+#include "WorkerPool.hpp"
+#include "Server.hpp"
+#include "EventManager.hpp"
+#include "../http/httpMethods/utils/FileCache.hpp"
+#include "../http/response/ResponseCache.hpp"
+#include "../http/response/GzipEncoder.hpp"
+#include "../http/httpMethods/get/DirectoryListing.hpp"
+#include <sched.h>
+
+volatile sig_atomic_t WorkerPool::s_stopRequested = 0;
+const int WorkerPool::MIN_WORKER_LIFETIME_SECONDS;
+
+WorkerPool::WorkerPool(const std::vector<ServerConfig>& configs,
+                       const std::map<std::string, std::string>& env,
+                       const GlobalConfig& global)
+    : configs(configs), env(env), global(global) {}
+
+void WorkerPool::handleStopSignal(int sig) {
+    (void)sig;
+    s_stopRequested = 1;
+}
+
+void WorkerPool::runEventLoop(bool reusePort) {
+    EventManager event_mgr(global.getEventBatchSize());
+    event_mgr.setEdgeTriggered(global.getEdgeTriggered());
+    event_mgr.setIoBudget(global.getIoBudget());
+    event_mgr.setStatsInterval(global.getEventStatsInterval());
+    FileCache::configure(global.getFileCacheMaxBytes(), global.getFileCacheValid());
+    ResponseCache::configure(global.getResponseCacheMaxBytes());
+    GzipEncoder::setCpuBudget(global.getGzipCpuBudget());
+    DirectoryListing::configure(global.getListingCacheMaxBytes());
+    Server server(configs, env);
+
+    server.setReusePort(reusePort);
+    server.initialize(event_mgr);
+    server.run(event_mgr);
+}
+
+void WorkerPool::pinToCpu(int index) {
+    long cpuCount = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpuCount < 1) {
+        return;
+    }
+
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(index % cpuCount, &cpus);
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) == -1) {
+        std::cerr << "[ERROR] Failed to pin worker " << index << " to CPU "
+                  << (index % cpuCount) << ": " << strerror(errno) << std::endl;
+    }
+}
+
+bool WorkerPool::spawnWorker(int index) {
+    pid_t pid = fork();
+
+    if (pid == -1) {
+        std::cerr << "[ERROR] Failed to fork worker " << index << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (pid == 0) {
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        if (global.getWorkerCpuAffinity()) {
+            pinToCpu(index);
+        }
+        try {
+            runEventLoop(true);
+        } catch (const std::exception& e) {
+            std::cerr << "[ERROR] Worker " << index << ": " << e.what() << std::endl;
+            std::exit(1);
+        }
+        std::exit(0);
+    }
+
+    WorkerProcess worker;
+    worker.index = index;
+    worker.startedAt = time(NULL);
+    workers[pid] = worker;
+    std::cout << "[INFO] Started worker " << index << " with pid=" << pid << std::endl;
+    return true;
+}
+
+void WorkerPool::stopWorkers() {
+    for (std::map<pid_t, WorkerProcess>::iterator it = workers.begin(); it != workers.end(); ++it) {
+        kill(it->first, SIGTERM);
+    }
+    for (std::map<pid_t, WorkerProcess>::iterator it = workers.begin(); it != workers.end(); ++it) {
+        int status;
+        waitpid(it->first, &status, 0);
+    }
+    workers.clear();
+}
+
+int WorkerPool::run() {
+    int count = global.getWorkerProcesses();
+
+    // sendfile() has no MSG_NOSIGNAL; a peer reset must come back as EPIPE
+    // rather than kill the worker. Inherited by every forked worker.
+    signal(SIGPIPE, SIG_IGN);
+
+    if (count <= 1) {
+        runEventLoop(false);
+        return 0;
+    }
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = handleStopSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    for (int i = 0; i < count; ++i) {
+        if (!spawnWorker(i)) {
+            stopWorkers();
+            return 1;
+        }
+    }
+
+    int exitCode = 0;
+    while (!s_stopRequested && !workers.empty()) {
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        std::map<pid_t, WorkerProcess>::iterator it = workers.find(pid);
+        if (it == workers.end()) {
+            continue;
+        }
+        WorkerProcess worker = it->second;
+        workers.erase(it);
+
+        if (s_stopRequested) {
+            break;
+        }
+
+        std::cerr << "[ERROR] Worker " << worker.index << " (pid=" << pid << ") exited unexpectedly" << std::endl;
+        if (time(NULL) - worker.startedAt < MIN_WORKER_LIFETIME_SECONDS) {
+            std::cerr << "[ERROR] Worker " << worker.index << " failed during startup, shutting down" << std::endl;
+            exitCode = 1;
+            break;
+        }
+        if (!spawnWorker(worker.index)) {
+            exitCode = 1;
+            break;
+        }
+    }
+
+    stopWorkers();
+    return exitCode;
+}
@@ -0,0 +1,36 @@
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+#include "../../include/webserv.hpp"
+#include "../config/ServerConfig.hpp"
+#include "../config/GlobalConfig.hpp"
+
+struct WorkerProcess {
+    int index;
+    time_t startedAt;
+};
+
+class WorkerPool {
+private:
+    std::vector<ServerConfig> configs;
+    std::map<std::string, std::string> env;
+    GlobalConfig global;
+    std::map<pid_t, WorkerProcess> workers;
+
+    static volatile sig_atomic_t s_stopRequested;
+    static const int MIN_WORKER_LIFETIME_SECONDS = 1;
+
+    static void handleStopSignal(int sig);
+    void runEventLoop(bool reusePort);
+    bool spawnWorker(int index);
+    void pinToCpu(int index);
+    void stopWorkers();
+public:
+    WorkerPool(const std::vector<ServerConfig>& configs,
+               const std::map<std::string, std::string>& env,
+               const GlobalConfig& global);
+
+    int run();
+};
+
+#endif
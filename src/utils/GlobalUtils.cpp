@@ -1,6 +1,7 @@
 #include "../../include/GlobalUtils.hpp"
 #include <unistd.h>
 #include <errno.h>
+#include <ctime>
 
 bool setToNonBlocking(int fd) {
     int flags = fcntl(fd, F_GETFL, 0);
@@ -22,3 +23,23 @@ std::string toLowerCase(const std::string& str) {
     }
     return result;
 }
+
+std::string formatHttpDate(time_t when) {
+    char buffer[64];
+    std::tm* gmt = std::gmtime(&when);
+    if (!gmt || std::strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT", gmt) == 0) {
+        return "";
+    }
+    return buffer;
+}
+
+bool parseHttpDate(const std::string& value, time_t& when) {
+    std::tm parsed;
+    std::memset(&parsed, 0, sizeof(parsed));
+    const char* end = strptime(value.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &parsed);
+    if (!end || *end != '\0') {
+        return false;
+    }
+    when = timegm(&parsed);
+    return when != static_cast<time_t>(-1);
+}